@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+#include <algorithm>
+#include <cstdio>
+
+struct BenchSummary {
+    qint64 medianUs;
+    qint64 p95Us;
+    qint64 meanUs;
+    qint64 totalMs;
+};
+
+inline BenchSummary summarize(QVector<qint64> samplesNs) {
+    if (samplesNs.isEmpty()) {
+        return {0, 0, 0, 0};
+    }
+    std::sort(samplesNs.begin(), samplesNs.end());
+    qint64 total = 0;
+    for (const qint64 sample : samplesNs) {
+        total += sample;
+    }
+    const qsizetype p95 = qMin<qsizetype>(samplesNs.size() - 1, samplesNs.size() * 95 / 100);
+    return {
+        samplesNs[samplesNs.size() / 2] / 1000,
+        samplesNs[p95] / 1000,
+        total / samplesNs.size() / 1000,
+        total / 1000000
+    };
+}
+
+template <typename Body>
+qint64 timeOnce(Body body) {
+    QElapsedTimer timer;
+    timer.start();
+    body();
+    return timer.nsecsElapsed();
+}
+
+template <typename Body>
+QVector<qint64> measure(int iterations, Body body) {
+    QVector<qint64> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations; i += 1) {
+        samples.append(timeOnce(body));
+    }
+    return samples;
+}
+
+inline void printSummary(const QString &label, const QVector<qint64> &samplesNs) {
+    const BenchSummary summary = summarize(samplesNs);
+    const QString line = QString("%1：%2 次，中位数 %3 us，P95 %4 us，平均 %5 us，合计 %6 ms")
+        .arg(label)
+        .arg(samplesNs.size())
+        .arg(summary.medianUs)
+        .arg(summary.p95Us)
+        .arg(summary.meanUs)
+        .arg(summary.totalMs);
+    std::printf("%s\n", line.toLocal8Bit().constData());
+}
@@ -0,0 +1,101 @@
+#include "BenchStats.h"
+#include "engine/JpegCodec.h"
+#include "engine/ProcessLauncher.h"
+#include "engine/ToolCatalog.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <cstdio>
+
+namespace {
+const int kTimeoutMs = 60000;
+
+void printLine(const QString &line) {
+    std::printf("%s\n", line.toLocal8Bit().constData());
+}
+
+QByteArray readFile(const QString &path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+bool writeFile(const QString &path, const QByteArray &data) {
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size();
+}
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QStringList params = app.arguments().mid(1);
+    if (params.size() < 2) {
+        printLine("用法：imgcompress_bench_jpeg <质量 1-100> <JPEG 文件...>");
+        return 1;
+    }
+    const int quality = qBound(1, params.takeFirst().toInt(), 100);
+    QTemporaryDir outputDir;
+    if (!outputDir.isValid()) {
+        printLine("无法创建临时目录");
+        return 1;
+    }
+    const QString nativeOutput = outputDir.filePath("native.jpg");
+    const QString toolOutput = outputDir.filePath("cjpeg.jpg");
+    const QString cjpeg = ToolCatalog::find({"cjpeg", "mozjpeg"});
+    const JpegEncodeSettings settings{quality, true, true, true};
+    QVector<qint64> nativeSamples;
+    QVector<qint64> toolSamples;
+    qint64 sourceBytes = 0;
+    qint64 nativeBytes = 0;
+    qint64 toolBytes = 0;
+    int nativeFailures = 0;
+    int toolFailures = 0;
+    for (const QString &source : params) {
+        sourceBytes += QFileInfo(source).size();
+        if (JpegCodec::isAvailable()) {
+            QByteArray encoded;
+            bool ok = false;
+            nativeSamples.append(timeOnce([&]() {
+                QString error;
+                ok = JpegCodec::recompress(readFile(source), settings, 0, &encoded, &error) == JpegCodec::Status::Success
+                    && writeFile(nativeOutput, encoded);
+            }));
+            nativeBytes += ok ? encoded.size() : 0;
+            nativeFailures += ok ? 0 : 1;
+        }
+        if (!cjpeg.isEmpty()) {
+            const QStringList args = {
+                "-quality",
+                QString::number(quality),
+                "-progressive",
+                "-optimize",
+                "-outfile",
+                toolOutput,
+                source
+            };
+            int code = -1;
+            toolSamples.append(timeOnce([&]() {
+                code = ProcessLauncher::run(cjpeg, args, kTimeoutMs).code;
+            }));
+            toolBytes += code == 0 ? QFileInfo(toolOutput).size() : 0;
+            toolFailures += code == 0 ? 0 : 1;
+        }
+    }
+    printLine(QString("有损 JPEG 编码：%1 个文件，质量 %2，原图合计 %3 字节").arg(params.size()).arg(quality).arg(sourceBytes));
+    if (JpegCodec::isAvailable()) {
+        printSummary(QString("%1(内置)").arg(JpegCodec::backendName()), nativeSamples);
+        printLine(QString("  输出 %1 字节，失败 %2 个，trellis %3").arg(nativeBytes).arg(nativeFailures).arg(JpegCodec::supportsTrellis() ? "开启" : "不支持"));
+    } else {
+        printLine("内置编码器不可用（未链接 libjpeg）");
+    }
+    if (!cjpeg.isEmpty()) {
+        printSummary(QString("cjpeg(%1)").arg(cjpeg), toolSamples);
+        printLine(QString("  输出 %1 字节，失败 %2 个").arg(toolBytes).arg(toolFailures));
+    } else {
+        printLine("未找到 cjpeg/mozjpeg");
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "BenchStats.h"
+#include "engine/ProcessLauncher.h"
+#include "engine/ToolCatalog.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+
+#include <cstdio>
+
+namespace {
+const int kTimeoutMs = 60000;
+
+void printLine(const QString &line) {
+    std::printf("%s\n", line.toLocal8Bit().constData());
+}
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QStringList params = app.arguments().mid(1);
+    if (params.size() < 3) {
+        printLine("用法：imgcompress_bench_pipeline <质量 1-100> <输出目录> <WebP 文件...>");
+        return 1;
+    }
+    const int quality = qBound(1, params.takeFirst().toInt(), 100);
+    const QDir outputDir(params.takeFirst());
+    if (!outputDir.exists()) {
+        printLine(QString("输出目录不存在：%1").arg(outputDir.path()));
+        return 1;
+    }
+    const QString dwebp = ToolCatalog::find({"dwebp"});
+    const QString cjpeg = ToolCatalog::find({"cjpeg", "mozjpeg"});
+    if (dwebp.isEmpty() || cjpeg.isEmpty()) {
+        printLine("需要 dwebp 与 cjpeg/mozjpeg");
+        return 1;
+    }
+    const QString output = outputDir.filePath(".imgcompress_bench.jpg");
+    const QString tempPath = outputDir.filePath(".imgcompress_bench.ppm");
+    const QStringList encodeArgs = {"-quality", QString::number(quality), "-progressive", "-optimize", "-outfile", output};
+    QVector<qint64> pipedSamples;
+    QVector<qint64> tempSamples;
+    int pipedFailures = 0;
+    int tempFailures = 0;
+    for (const QString &source : params) {
+        int code = -1;
+        pipedSamples.append(timeOnce([&]() {
+            code = ProcessLauncher::runPipeline(
+                {{dwebp, {"-quiet", "-ppm", source, "-o", "-"}}, {cjpeg, encodeArgs}},
+                QByteArray(),
+                kTimeoutMs
+            ).code;
+        }));
+        pipedFailures += code == 0 ? 0 : 1;
+        QFile::remove(output);
+        tempSamples.append(timeOnce([&]() {
+            code = ProcessLauncher::run(dwebp, {"-quiet", "-ppm", source, "-o", tempPath}, kTimeoutMs).code;
+            if (code == 0) {
+                code = ProcessLauncher::run(cjpeg, QStringList(encodeArgs) << tempPath, kTimeoutMs).code;
+            }
+            QFile::remove(tempPath);
+        }));
+        tempFailures += code == 0 ? 0 : 1;
+        QFile::remove(output);
+    }
+    printLine(QString("WebP → JPG：%1 个文件，质量 %2，输出目录 %3").arg(params.size()).arg(quality).arg(outputDir.absolutePath()));
+    printSummary("dwebp | cjpeg 管道", pipedSamples);
+    printLine(QString("  失败 %1 个").arg(pipedFailures));
+    printSummary("dwebp → 临时 PPM → cjpeg", tempSamples);
+    printLine(QString("  失败 %1 个").arg(tempFailures));
+    return 0;
+}
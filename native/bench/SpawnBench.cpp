@@ -0,0 +1,58 @@
+#include "BenchStats.h"
+#include "engine/ProcessLauncher.h"
+
+#include <QCoreApplication>
+#include <QProcess>
+#include <QStringList>
+
+#include <cstdio>
+
+namespace {
+const int kTimeoutMs = 10000;
+
+int runQProcess(const QString &program, const QStringList &args) {
+    QProcess process;
+    process.setProgram(program);
+    process.setArguments(args);
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start();
+    if (!process.waitForFinished(kTimeoutMs)) {
+        process.kill();
+        process.waitForFinished(2000);
+        return -2;
+    }
+    process.readAllStandardOutput();
+    return process.exitStatus() == QProcess::NormalExit ? process.exitCode() : -1;
+}
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QStringList params = app.arguments().mid(1);
+    const int iterations = params.isEmpty() ? 200 : qMax(1, params.takeFirst().toInt());
+#if defined(Q_OS_WIN)
+    QString program = "cmd";
+    QStringList args = {"/c", "exit", "0"};
+#else
+    QString program = "/bin/true";
+    QStringList args;
+#endif
+    if (!params.isEmpty()) {
+        program = params.takeFirst();
+        args = params;
+    }
+    if (ProcessLauncher::run(program, args, kTimeoutMs).code != 0 || runQProcess(program, args) != 0) {
+        std::printf("%s\n", QString("无法运行 %1").arg(program).toLocal8Bit().constData());
+        return 1;
+    }
+    const QVector<qint64> launcher = measure(iterations, [&]() {
+        ProcessLauncher::run(program, args, kTimeoutMs);
+    });
+    const QVector<qint64> qprocess = measure(iterations, [&]() {
+        runQProcess(program, args);
+    });
+    std::printf("%s\n", QString("启动延迟：%1 %2").arg(program, args.join(' ')).toLocal8Bit().constData());
+    printSummary("ProcessLauncher", launcher);
+    printSummary("QProcess", qprocess);
+    return 0;
+}
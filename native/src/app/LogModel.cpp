@@ -0,0 +1,137 @@
+#include "LogModel.h"
+
+#include <QBrush>
+#include <QColor>
+
+#include <algorithm>
+
+namespace {
+const int kCapacity = 100000;
+}
+
+LogModel::LogModel(QObject *parent)
+    : QAbstractListModel(parent),
+      head(0),
+      count(0),
+      firstSequence(0) {}
+
+int LogModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : count;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= count) {
+        return QVariant();
+    }
+    const LogRecord &entry = at(index.row());
+    if (role == Qt::DisplayRole) {
+        return entry.text();
+    }
+    if (role == Qt::ForegroundRole) {
+        if (isMatch(index.row())) {
+            return QBrush(QColor("#0b0f1a"));
+        }
+        if (entry.kind == LogKind::Warning) {
+            return QBrush(QColor("#f59e0b"));
+        }
+        if (entry.kind == LogKind::Failed) {
+            return QBrush(QColor("#ef4444"));
+        }
+        return QBrush(QColor("#e5e7eb"));
+    }
+    if (role == Qt::BackgroundRole && isMatch(index.row())) {
+        return QBrush(QColor("#f59e0b"));
+    }
+    return QVariant();
+}
+
+void LogModel::append(const QVector<LogRecord> &batch) {
+    if (batch.isEmpty()) {
+        return;
+    }
+    const int incoming = qMin(static_cast<int>(batch.size()), kCapacity);
+    const int overflow = count + incoming - kCapacity;
+    if (overflow > 0) {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        ring.resize(kCapacity);
+        head = (head + overflow) % kCapacity;
+        count -= overflow;
+        firstSequence += overflow;
+        const auto kept = std::lower_bound(matchSequences.begin(), matchSequences.end(), firstSequence);
+        matchSequences.erase(matchSequences.begin(), kept);
+        endRemoveRows();
+    }
+    beginInsertRows(QModelIndex(), count, count + incoming - 1);
+    for (int i = batch.size() - incoming; i < batch.size(); i += 1) {
+        const int slot = (head + count) % kCapacity;
+        if (slot == ring.size()) {
+            ring.append(batch[i]);
+        } else {
+            ring[slot] = batch[i];
+        }
+        if (!searchKeyword.isEmpty() && matches(batch[i], searchKeyword)) {
+            matchSequences.append(firstSequence + count);
+        }
+        count += 1;
+    }
+    endInsertRows();
+}
+
+void LogModel::clear() {
+    beginResetModel();
+    ring.clear();
+    head = 0;
+    count = 0;
+    firstSequence = 0;
+    matchSequences.clear();
+    endResetModel();
+}
+
+void LogModel::setKeyword(const QString &keyword) {
+    if (keyword == searchKeyword) {
+        return;
+    }
+    const bool narrowing = !searchKeyword.isEmpty() && keyword.contains(searchKeyword, Qt::CaseInsensitive);
+    searchKeyword = keyword;
+    if (keyword.isEmpty()) {
+        matchSequences.clear();
+    } else if (narrowing) {
+        QVector<quint64> kept;
+        for (const quint64 sequence : matchSequences) {
+            if (matches(at(static_cast<int>(sequence - firstSequence)), keyword)) {
+                kept.append(sequence);
+            }
+        }
+        matchSequences = kept;
+    } else {
+        matchSequences.clear();
+        for (int row = 0; row < count; row += 1) {
+            if (matches(at(row), keyword)) {
+                matchSequences.append(firstSequence + row);
+            }
+        }
+    }
+    if (count > 0) {
+        emit dataChanged(index(0), index(count - 1), {Qt::ForegroundRole, Qt::BackgroundRole});
+    }
+}
+
+QString LogModel::textAt(int row) const {
+    return row >= 0 && row < count ? at(row).text() : QString();
+}
+
+const LogRecord &LogModel::at(int row) const {
+    return ring[(head + row) % kCapacity];
+}
+
+bool LogModel::matches(const LogRecord &entry, const QString &keyword) const {
+    if (entry.file.contains(keyword, Qt::CaseInsensitive) || entry.detail.contains(keyword, Qt::CaseInsensitive)) {
+        return true;
+    }
+    return (entry.kind == LogKind::Compressed || entry.kind == LogKind::Failed)
+        && entry.text().contains(keyword, Qt::CaseInsensitive);
+}
+
+bool LogModel::isMatch(int row) const {
+    return std::binary_search(matchSequences.begin(), matchSequences.end(), firstSequence + row);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVector>
+
+#include "core/LogRecord.h"
+
+class LogModel final : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    explicit LogModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void append(const QVector<LogRecord> &batch);
+    void clear();
+    void setKeyword(const QString &keyword);
+    QString textAt(int row) const;
+
+private:
+    const LogRecord &at(int row) const;
+    bool matches(const LogRecord &entry, const QString &keyword) const;
+    bool isMatch(int row) const;
+
+    QVector<LogRecord> ring;
+    int head;
+    int count;
+    quint64 firstSequence;
+    QString searchKeyword;
+    QVector<quint64> matchSequences;
+};
@@ -1,13 +1,14 @@
 #include "MainWindow.h"
 
 #include <QAbstractItemView>
+#include <QAction>
 #include <QApplication>
 #include <QBrush>
 #include <QCheckBox>
+#include <QClipboard>
 #include <QComboBox>
 #include <QColor>
 #include <QDir>
-#include <QDirIterator>
 #include <QDragEnterEvent>
 #include <QDragLeaveEvent>
 #include <QDropEvent>
@@ -19,21 +20,18 @@
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QIntValidator>
+#include <QKeySequence>
 #include <QLabel>
 #include <QLineEdit>
 #include <QListView>
 #include <QMimeData>
-#include <QPlainTextEdit>
 #include <QPushButton>
 #include <QProgressBar>
+#include <QScrollBar>
 #include <QSizePolicy>
 #include <QSlider>
 #include <QStandardItemModel>
 #include <QSet>
-#include <QTextCharFormat>
-#include <QTextCursor>
-#include <QTextEdit>
-#include <QTextDocument>
 #include <QThread>
 #include <QUrl>
 #include <QVBoxLayout>
@@ -41,6 +39,8 @@
 #include <algorithm>
 
 #include "core/CompressController.h"
+#include "core/FileScanner.h"
+#include "app/LogModel.h"
 #include "engine/EngineRegistry.h"
 
 DropArea::DropArea(QWidget *parent) : QFrame(parent) {
@@ -120,12 +120,38 @@ void DropArea::dropEvent(QDropEvent *event) {
     event->acceptProposedAction();
 }
 
-MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), isRunning(false) {
+MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), isRunning(false), dropPending(false) {
     setupUi();
+    scanner = new FileScanner(this);
+    connect(scanner, &FileScanner::formatsChanged, this, [this](const QSet<QString> &formats) {
+        if (!dropPending && selectedFiles.isEmpty()) {
+            inputFormats = formats;
+            updateCompressionOptionsState();
+        }
+    });
+    connect(scanner, &FileScanner::progress, this, [this](int files) {
+        if (dropPending) {
+            filesLine->setText(QString("正在扫描：已发现 %1 张图片").arg(files));
+        }
+    });
+    connect(scanner, &FileScanner::finished, this, [this]() {
+        if (dropPending) {
+            finishDrop();
+        }
+    });
     controller = new CompressController(this);
     connect(controller, &CompressController::logMessage, this, &MainWindow::onLogMessage);
+    connect(controller, &CompressController::logRecords, this, &MainWindow::onLogRecords);
     connect(controller, &CompressController::progressChanged, this, &MainWindow::onProgressChanged);
     connect(controller, &CompressController::finished, this, &MainWindow::onFinished);
+    connect(controller, &CompressController::watchingChanged, this, [this](bool watching) {
+        watchButton->setText(watching ? "停止监听" : "监听目录");
+        if (watching) {
+            isRunning = true;
+            startButton->setEnabled(false);
+            progressBar->setValue(0);
+        }
+    });
 }
 
 void MainWindow::setupUi() {
@@ -203,13 +229,16 @@ void MainWindow::setupUi() {
         "QPlainTextEdit#card {"
         " padding: 10px;"
         "}"
-        "QPlainTextEdit#log {"
+        "QListView#log {"
         " background: #0b0f1a;"
         " color: #e5e7eb;"
         " border: 1px solid #0f172a;"
         " border-radius: 16px;"
         " padding: 12px;"
         "}"
+        "QListView#log::item:selected {"
+        " background: #1e3a8a;"
+        "}"
         "QLineEdit, QComboBox, QSpinBox {"
         " background: #f9fafb;"
         " border: 1px solid #e5e7eb;"
@@ -335,16 +364,33 @@ void MainWindow::setupUi() {
     dropArea = new DropArea(this);
     dropArea->setObjectName("card");
     connect(dropArea, &DropArea::dropped, this, &MainWindow::onDropPaths);
-    logArea = new QPlainTextEdit(this);
-    logArea->setObjectName("log");
-    logArea->setReadOnly(true);
-    logArea->setPlaceholderText("压缩日志将在这里显示");
-    logArea->setMinimumHeight(240);
+    logModel = new LogModel(this);
+    logView = new QListView(this);
+    logView->setObjectName("log");
+    logView->setModel(logModel);
+    logView->setUniformItemSizes(true);
+    logView->setWordWrap(false);
+    logView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    logView->setMinimumHeight(240);
+    auto *copyAction = new QAction(logView);
+    copyAction->setShortcut(QKeySequence::Copy);
+    copyAction->setShortcutContext(Qt::WidgetShortcut);
+    connect(copyAction, &QAction::triggered, this, [this]() {
+        QModelIndexList rows = logView->selectionModel()->selectedRows();
+        std::sort(rows.begin(), rows.end());
+        QStringList lines;
+        for (const QModelIndex &row : rows) {
+            lines << logModel->textAt(row.row());
+        }
+        QApplication::clipboard()->setText(lines.join("\n"));
+    });
+    logView->addAction(copyAction);
     logSearchInput = new QLineEdit(this);
     logSearchInput->setPlaceholderText("搜索日志");
     logSearchInput->setMinimumHeight(30);
-    connect(logSearchInput, &QLineEdit::textChanged, this, [this]() {
-        updateLogSearchHighlights();
+    connect(logSearchInput, &QLineEdit::textChanged, this, [this](const QString &text) {
+        logModel->setKeyword(text.trimmed());
     });
 
     auto *pathGroup = new QGroupBox(this);
@@ -444,12 +490,12 @@ void MainWindow::setupUi() {
     if (idealThreads < 1) {
         idealThreads = 4;
     }
-    const int maxThreads = qMax(1, idealThreads - 1);
+    const int maxJobs = qMax(64, idealThreads * 4);
     engineLevelCombo = new QComboBox(this);
-    for (int i = 1; i <= maxThreads; i += 1) {
+    for (int i = 1; i <= maxJobs; i += 1) {
         engineLevelCombo->addItem(QString::number(i), i);
     }
-    engineLevelCombo->setCurrentIndex(maxThreads - 1);
+    engineLevelCombo->setCurrentIndex(idealThreads - 1);
     engineLevelCombo->setFixedWidth(72);
 
     outputFormatCombo = new QComboBox(this);
@@ -511,6 +557,11 @@ void MainWindow::setupUi() {
     startButton->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     connect(startButton, &QPushButton::clicked, this, &MainWindow::startCompression);
 
+    watchButton = new QPushButton("监听目录", this);
+    watchButton->setObjectName("secondary");
+    watchButton->setMinimumHeight(44);
+    connect(watchButton, &QPushButton::clicked, this, &MainWindow::toggleWatching);
+
     connect(losslessCheck, &QCheckBox::toggled, this, [this]() {
         updateCompressionOptionsState();
         updateOutputFormatOptions();
@@ -518,7 +569,7 @@ void MainWindow::setupUi() {
 
     auto *actionLayout = new QHBoxLayout();
     actionLayout->setSpacing(10);
-    auto *concurrencyLabel = new QLabel("线程数", this);
+    auto *concurrencyLabel = new QLabel("并发数", this);
     auto *concurrencyBox = new QWidget(this);
     auto *concurrencyLayout = new QHBoxLayout(concurrencyBox);
     concurrencyLayout->setContentsMargins(0, 0, 0, 0);
@@ -528,6 +579,7 @@ void MainWindow::setupUi() {
     actionLayout->addWidget(concurrencyBox);
     actionLayout->addWidget(progressBar, 1);
     actionLayout->addWidget(startButton);
+    actionLayout->addWidget(watchButton);
     optionsGroupLayout->addLayout(actionLayout);
     optionsGroup->setLayout(optionsGroupLayout);
     optionsGroup->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
@@ -548,7 +600,7 @@ void MainWindow::setupUi() {
     logLayout->setContentsMargins(0, 0, 0, 0);
     logLayout->setSpacing(8);
     logLayout->addWidget(logSearchInput);
-    logLayout->addWidget(logArea, 1);
+    logLayout->addWidget(logView, 1);
 
     rootLayout->addWidget(dropArea, 0, 0);
     rootLayout->addWidget(logContainer, 1, 0);
@@ -622,8 +674,7 @@ void MainWindow::startCompression() {
         if (outputDir.isEmpty()) {
             outputDir = baseDir;
         }
-        logArea->clear();
-        updateLogSearchHighlights();
+        logModel->clear();
         if (!startFilesCompression(selectedFiles, baseDir, outputDir, formats)) {
             return;
         }
@@ -638,41 +689,85 @@ void MainWindow::startCompression() {
             onLogMessage("请输入有效的输入目录");
             return;
         }
-        inputFormats = collectInputFormatsFromDir(inputDir);
-        updateOutputFormatOptions();
-        const QStringList formats = buildFormatsForWorker();
-        if (formats.isEmpty()) {
-            onLogMessage("未找到可压缩图片");
-            return;
+        QStringList formats = {"jpg", "jpeg", "png", "gif", "webp"};
+        QVector<WalkedFile> scannedFiles;
+        if (scanner->isFresh({inputDir})) {
+            inputFormats = scanner->formats();
+            updateOutputFormatOptions();
+            formats = buildFormatsForWorker();
+            if (formats.isEmpty()) {
+                onLogMessage("未找到可压缩图片");
+                return;
+            }
+            scannedFiles = scanner->files();
+        } else {
+            scanner->cancel();
+            updateOutputFormatOptions();
         }
         if (outputDir.isEmpty()) {
             outputDir = inputDir;
         }
-        logArea->clear();
-        updateLogSearchHighlights();
-        if (!startDirCompression(inputDir, outputDir, formats)) {
+        logModel->clear();
+        if (!startDirCompression(inputDir, outputDir, formats, scannedFiles)) {
             return;
         }
     }
     isRunning = true;
     startButton->setEnabled(false);
+    watchButton->setEnabled(false);
     progressBar->setValue(0);
 }
 
+void MainWindow::toggleWatching() {
+    if (controller->isWatching()) {
+        controller->stopWatching();
+        return;
+    }
+    if (isRunning) {
+        return;
+    }
+    const QString inputDir = inputLine->text().trimmed();
+    const QString outputDir = outputLine->text().trimmed();
+    if (inputDir.isEmpty() || !QDir(inputDir).exists()) {
+        onLogMessage("请输入有效的输入目录");
+        return;
+    }
+    const QString outputFormat = selectedOutputFormat();
+    const int resizeMode = resizeModeCombo->currentData().toInt();
+    const bool resizeEnabled = resizeMode != 0;
+    int targetWidth = 0;
+    int targetHeight = 0;
+    if (resizeEnabled && !readResizeSize(targetWidth, targetHeight)) {
+        return;
+    }
+    logModel->clear();
+    controller->startWatching(
+        inputDir,
+        outputDir,
+        {"jpg", "jpeg", "png", "gif", "webp"},
+        losslessCheck->isChecked(),
+        qualitySlider->value(),
+        profileCombo->currentText(),
+        outputFormat,
+        engineLevelCombo->currentData().toInt(),
+        resizeEnabled,
+        targetWidth,
+        targetHeight,
+        resizeMode
+    );
+}
+
 void MainWindow::onLogMessage(const QString &message) {
-    QTextCharFormat format;
-    const QString trimmed = message.trimmed();
-    if (message.contains("实际格式为") && message.contains("不一致")) {
-        format.setForeground(QColor("#f59e0b"));
-    } else {
-        format.setForeground(trimmed.startsWith("失败") ? QColor("#ef4444") : QColor("#e5e7eb"));
+    onLogRecords({LogRecord::message(message)});
+}
+
+void MainWindow::onLogRecords(const QVector<LogRecord> &records) {
+    const QScrollBar *scrollBar = logView->verticalScrollBar();
+    const bool following = scrollBar->value() >= scrollBar->maximum();
+    logModel->append(records);
+    if (following) {
+        logView->scrollToBottom();
     }
-    QTextCursor cursor = logArea->textCursor();
-    cursor.movePosition(QTextCursor::End);
-    cursor.insertText(message + "\n", format);
-    logArea->setTextCursor(cursor);
-    logArea->ensureCursorVisible();
-    updateLogSearchHighlights();
 }
 
 void MainWindow::onProgressChanged(int percent) {
@@ -683,6 +778,7 @@ void MainWindow::onFinished() {
     progressBar->setValue(100);
     isRunning = false;
     startButton->setEnabled(true);
+    watchButton->setEnabled(true);
     updateSelectionMode();
 }
 
@@ -693,8 +789,19 @@ void MainWindow::onDropPaths(const QStringList &paths) {
     if (paths.isEmpty()) {
         return;
     }
-    logUnsupportedFiles(collectUnsupportedFilesFromPaths(paths));
-    const QStringList files = collectFilesFromPaths(paths);
+    dropPending = true;
+    startButton->setEnabled(false);
+    filesLine->setText("正在扫描拖入的文件…");
+    scanner->scan(paths);
+}
+
+void MainWindow::finishDrop() {
+    dropPending = false;
+    const QStringList paths = scanner->paths();
+    const QStringList files = scanner->filePaths();
+    updateFileSummary();
+    updateSelectionMode();
+    logUnsupportedFiles(scanner->unsupportedFiles());
     if (!files.isEmpty()) {
         inputLine->clear();
         setSelectedFiles(files);
@@ -711,11 +818,11 @@ void MainWindow::onDropPaths(const QStringList &paths) {
         if (outputDir.isEmpty()) {
             outputDir = baseDir;
         }
-        logArea->clear();
-        updateLogSearchHighlights();
+        logModel->clear();
         if (startFilesCompression(files, baseDir, outputDir, formats)) {
             isRunning = true;
             startButton->setEnabled(false);
+            watchButton->setEnabled(false);
             progressBar->setValue(0);
         }
         return;
@@ -733,28 +840,6 @@ void MainWindow::onDropPaths(const QStringList &paths) {
     onLogMessage("未找到可压缩图片");
 }
 
-void MainWindow::updateLogSearchHighlights() {
-    const QString keyword = logSearchInput->text().trimmed();
-    QList<QTextEdit::ExtraSelection> selections;
-    if (!keyword.isEmpty()) {
-        QTextCursor cursor(logArea->document());
-        QTextCharFormat format;
-        format.setBackground(QColor("#f59e0b"));
-        format.setForeground(QColor("#0b0f1a"));
-        while (true) {
-            cursor = logArea->document()->find(keyword, cursor);
-            if (cursor.isNull()) {
-                break;
-            }
-            QTextEdit::ExtraSelection selection;
-            selection.cursor = cursor;
-            selection.format = format;
-            selections.append(selection);
-        }
-    }
-    logArea->setExtraSelections(selections);
-}
-
 void MainWindow::updateSelectionMode() {
     const bool hasFiles = !selectedFiles.isEmpty();
     inputLine->setEnabled(!hasFiles);
@@ -782,71 +867,6 @@ void MainWindow::updateFileSummary() {
     filesLine->setText(QString("已选择 %1 张图片").arg(selectedFiles.size()));
 }
 
-QStringList MainWindow::collectFilesFromPaths(const QStringList &paths) const {
-    const QStringList filters = {"*.jpg", "*.jpeg", "*.png", "*.gif", "*.webp"};
-    QSet<QString> found;
-    for (const QString &path : paths) {
-        QFileInfo info(path);
-        if (!info.exists()) {
-            continue;
-        }
-        if (info.isFile()) {
-            const QString suffix = info.suffix().toLower();
-            if (suffix == "jpg" || suffix == "jpeg" || suffix == "png" || suffix == "gif" || suffix == "webp") {
-                found.insert(info.absoluteFilePath());
-            }
-            continue;
-        }
-        if (info.isDir()) {
-            QDirIterator it(info.absoluteFilePath(), filters, QDir::Files, QDirIterator::Subdirectories);
-            while (it.hasNext()) {
-                found.insert(it.next());
-            }
-        }
-    }
-    return QStringList(found.begin(), found.end());
-}
-
-static bool isSupportedImageSuffix(const QString &suffix) {
-    return suffix == "jpg" || suffix == "jpeg" || suffix == "png" || suffix == "gif" || suffix == "webp";
-}
-
-static bool isKnownImageSuffix(const QString &suffix) {
-    return isSupportedImageSuffix(suffix)
-        || suffix == "bmp"
-        || suffix == "tif"
-        || suffix == "tiff"
-        || suffix == "heic"
-        || suffix == "heif"
-        || suffix == "avif"
-        || suffix == "svg";
-}
-
-QStringList MainWindow::collectUnsupportedFilesFromPaths(const QStringList &paths) const {
-    const QStringList filters = {"*.bmp", "*.tif", "*.tiff", "*.heic", "*.heif", "*.avif", "*.svg"};
-    QSet<QString> found;
-    for (const QString &path : paths) {
-        QFileInfo info(path);
-        if (!info.exists()) {
-            continue;
-        }
-        if (info.isFile()) {
-            const QString suffix = info.suffix().toLower();
-            if (!suffix.isEmpty() && isKnownImageSuffix(suffix) && !isSupportedImageSuffix(suffix)) {
-                found.insert(info.absoluteFilePath());
-            }
-            continue;
-        }
-        if (info.isDir()) {
-            QDirIterator it(info.absoluteFilePath(), filters, QDir::Files, QDirIterator::Subdirectories);
-            while (it.hasNext()) {
-                found.insert(it.next());
-            }
-        }
-    }
-    return QStringList(found.begin(), found.end());
-}
-
 void MainWindow::logUnsupportedFiles(const QStringList &files) {
     if (files.isEmpty()) {
         return;
@@ -932,7 +952,8 @@ QStringList MainWindow::openFilesDialog(const QString &title) {
 bool MainWindow::startDirCompression(
     const QString &inputDir,
     const QString &outputDir,
-    const QStringList &formats
+    const QStringList &formats,
+    const QVector<WalkedFile> &scannedFiles
 ) {
     if (outputDir.trimmed().isEmpty()) {
         onLogMessage("请输入有效的输出目录");
@@ -955,6 +976,7 @@ bool MainWindow::startDirCompression(
         inputDir,
         outputDir,
         formats,
+        scannedFiles,
         losslessCheck->isChecked(),
         qualitySlider->value(),
         profileCombo->currentText(),
@@ -1041,13 +1063,24 @@ void MainWindow::updateCompressionOptionsState() {
 }
 
 void MainWindow::updateInputFormatsFromSelection() {
+    if (dropPending) {
+        dropPending = false;
+        updateFileSummary();
+    }
     if (!selectedFiles.isEmpty()) {
+        scanner->cancel();
         inputFormats = collectInputFormatsFromFiles(selectedFiles);
     } else {
         const QString dir = inputLine->text().trimmed();
         if (!dir.isEmpty() && QDir(dir).exists()) {
-            inputFormats = collectInputFormatsFromDir(dir);
+            const QStringList roots = {dir};
+            const bool current = scanner->isScanning() ? scanner->paths() == roots : scanner->isFresh(roots);
+            if (!current) {
+                scanner->scan(roots);
+            }
+            inputFormats = scanner->formats();
         } else {
+            scanner->cancel();
             inputFormats.clear();
         }
     }
@@ -1067,21 +1100,6 @@ QSet<QString> MainWindow::collectInputFormatsFromFiles(const QStringList &files)
     return fmts;
 }
 
-QSet<QString> MainWindow::collectInputFormatsFromDir(const QString &dir) const {
-    QSet<QString> fmts;
-    const QStringList filters = {"*.jpg", "*.jpeg", "*.png", "*.gif", "*.webp"};
-    QDirIterator it(dir, filters, QDir::Files, QDirIterator::Subdirectories);
-    while (it.hasNext()) {
-        const QString suf = QFileInfo(it.next()).suffix().toLower();
-        if (suf == "jpg" || suf == "jpeg") {
-            fmts.insert("jpg");
-        } else if (suf == "png" || suf == "gif" || suf == "webp") {
-            fmts.insert(suf);
-        }
-    }
-    return fmts;
-}
-
 QStringList MainWindow::buildFormatsForWorker() const {
     QStringList result;
     if (inputFormats.contains("jpg")) {
@@ -1154,8 +1172,7 @@ bool MainWindow::isOutputFormatEnabled(int index) const {
 void MainWindow::updateResizeModeOptions() {
     const bool lossless = losslessCheck->isChecked();
     const bool hasWebp = inputFormats.contains("webp");
-    const bool hasDwebp = EngineRegistry::toolExists("dwebp");
-    const bool blockResize = hasWebp && !hasDwebp;
+    const bool blockResize = hasWebp && !EngineRegistry::canResizeWebp();
     for (int i = 0; i < resizeModeCombo->count(); ++i) {
         const QVariant v = resizeModeCombo->itemData(i);
         const int mode = v.isValid() ? v.toInt() : 0;
@@ -1175,8 +1192,8 @@ void MainWindow::updateOutputFormatOptions() {
     const bool hasWebp = inputFormats.contains("webp");
     const bool hasOther = inputFormats.contains("jpg") || inputFormats.contains("png");
     const bool onlyGif = hasGif && !hasWebp && !hasOther;
-    const bool hasCwebp = EngineRegistry::toolExists("cwebp");
-    const bool hasDwebp = EngineRegistry::toolExists("dwebp");
+    const bool hasCwebp = EngineRegistry::canEncodeWebp();
+    const bool hasDwebp = EngineRegistry::canDecodeWebp();
     setOutputFormatEnabled("original", true);
     if (lossless) {
         setOutputFormatEnabled("jpg", true);
@@ -1184,7 +1201,7 @@ void MainWindow::updateOutputFormatOptions() {
         setOutputFormatEnabled("webp", false);
         setOutputFormatEnabled("gif", false);
     } else {
-        const bool allowWebp = hasCwebp && !resizeEnabled && !hasGif;
+        const bool allowWebp = hasCwebp && (!resizeEnabled || EngineRegistry::canResizeWebp()) && !hasGif;
         setOutputFormatEnabled("webp", allowWebp);
         setOutputFormatEnabled("gif", onlyGif);
         const bool allowJpgPng = !(hasWebp && !hasDwebp);
@@ -4,6 +4,7 @@
 #include <QFrame>
 #include <QSet>
 #include <QStringList>
+#include <QVector>
 
 class QLineEdit;
 class QPushButton;
@@ -11,12 +12,16 @@ class QCheckBox;
 class QComboBox;
 class QSlider;
 class QLabel;
-class QPlainTextEdit;
+class QListView;
 class QProgressBar;
 class QIntValidator;
 class QSpinBox;
 
 class CompressController;
+class FileScanner;
+class LogModel;
+struct LogRecord;
+struct WalkedFile;
 class QDragEnterEvent;
 class QDragLeaveEvent;
 class QDropEvent;
@@ -48,7 +53,9 @@ private slots:
     void pickFiles();
     void clearSelectedFiles();
     void startCompression();
+    void toggleWatching();
     void onLogMessage(const QString &message);
+    void onLogRecords(const QVector<LogRecord> &records);
     void onProgressChanged(int percent);
     void onFinished();
     void onDropPaths(const QStringList &paths);
@@ -64,15 +71,12 @@ private:
     void setOutputFormatEnabled(const QString &format, bool enabled);
     bool isResizeModeEnabled(int index) const;
     bool isOutputFormatEnabled(int index) const;
-    void updateLogSearchHighlights();
     bool readResizeSize(int &width, int &height);
     void setSelectedFiles(const QStringList &files);
     void updateFileSummary();
-    QStringList collectFilesFromPaths(const QStringList &paths) const;
-    QStringList collectUnsupportedFilesFromPaths(const QStringList &paths) const;
+    void finishDrop();
     void logUnsupportedFiles(const QStringList &files);
     QSet<QString> collectInputFormatsFromFiles(const QStringList &files) const;
-    QSet<QString> collectInputFormatsFromDir(const QString &dir) const;
     QStringList buildFormatsForWorker() const;
     QString commonBaseDir(const QStringList &files) const;
     QString selectedOutputFormat() const;
@@ -81,7 +85,8 @@ private:
     bool startDirCompression(
         const QString &inputDir,
         const QString &outputDir,
-        const QStringList &formats
+        const QStringList &formats,
+        const QVector<WalkedFile> &scannedFiles
     );
     bool startFilesCompression(
         const QStringList &files,
@@ -105,13 +110,17 @@ private:
     QLabel *qualityValue;
     QComboBox *engineLevelCombo;
     QPushButton *startButton;
+    QPushButton *watchButton;
     QPushButton *filesButton;
     QProgressBar *progressBar;
-    QPlainTextEdit *logArea;
+    QListView *logView;
+    LogModel *logModel;
     QLineEdit *logSearchInput;
     CompressController *controller;
+    FileScanner *scanner;
     DropArea *dropArea;
     QStringList selectedFiles;
     QSet<QString> inputFormats;
     bool isRunning;
+    bool dropPending;
 };
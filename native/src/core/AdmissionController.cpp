@@ -0,0 +1,82 @@
+#include "AdmissionController.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_MACOS)
+#include <sys/sysctl.h>
+#include <sys/types.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+qint64 physicalMemory() {
+#if defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? static_cast<qint64>(status.ullTotalPhys) : 0;
+#elif defined(Q_OS_MACOS)
+    int64_t size = 0;
+    size_t length = sizeof(size);
+    return sysctlbyname("hw.memsize", &size, &length, nullptr, 0) == 0 ? static_cast<qint64>(size) : 0;
+#else
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGE_SIZE);
+    return pages > 0 && pageSize > 0 ? static_cast<qint64>(pages) * pageSize : 0;
+#endif
+}
+}
+
+AdmissionController::AdmissionController(qint64 budgetBytes)
+    : limit(qMax<qint64>(0, budgetBytes)),
+      used(0),
+      peakUsed(0),
+      lightRunning(0),
+      heavyRunning(0) {}
+
+qint64 AdmissionController::defaultBudget() {
+    return physicalMemory() / 2;
+}
+
+bool AdmissionController::isEnabled() const {
+    return limit > 0;
+}
+
+bool AdmissionController::fits(const ResourceEstimate &estimate) const {
+    if (!isEnabled() || runningIn(estimate.resourceClass) == 0) {
+        return true;
+    }
+    return used + estimate.bytes <= limit;
+}
+
+void AdmissionController::acquire(int ticket, const ResourceEstimate &estimate) {
+    grants.insert(ticket, {estimate.resourceClass, estimate.bytes});
+    runningIn(estimate.resourceClass) += 1;
+    used += estimate.bytes;
+    peakUsed = qMax(peakUsed, used);
+}
+
+void AdmissionController::release(int ticket) {
+    if (!grants.contains(ticket)) {
+        return;
+    }
+    const Grant grant = grants.take(ticket);
+    runningIn(grant.resourceClass) -= 1;
+    used -= grant.bytes;
+}
+
+qint64 AdmissionController::budget() const {
+    return limit;
+}
+
+qint64 AdmissionController::peak() const {
+    return peakUsed;
+}
+
+int &AdmissionController::runningIn(ResourceClass resourceClass) {
+    return resourceClass == ResourceClass::Heavy ? heavyRunning : lightRunning;
+}
+
+int AdmissionController::runningIn(ResourceClass resourceClass) const {
+    return resourceClass == ResourceClass::Heavy ? heavyRunning : lightRunning;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "engine/CompressionPlan.h"
+
+#include <QHash>
+#include <QtGlobal>
+
+class AdmissionController {
+public:
+    explicit AdmissionController(qint64 budgetBytes);
+
+    static qint64 defaultBudget();
+
+    bool isEnabled() const;
+    bool fits(const ResourceEstimate &estimate) const;
+    void acquire(int ticket, const ResourceEstimate &estimate);
+    void release(int ticket);
+    qint64 budget() const;
+    qint64 peak() const;
+
+private:
+    struct Grant {
+        ResourceClass resourceClass;
+        qint64 bytes;
+    };
+
+    int &runningIn(ResourceClass resourceClass);
+    int runningIn(ResourceClass resourceClass) const;
+
+    qint64 limit;
+    qint64 used;
+    qint64 peakUsed;
+    int lightRunning;
+    int heavyRunning;
+    QHash<int, Grant> grants;
+};
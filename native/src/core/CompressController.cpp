@@ -3,13 +3,42 @@
 #include <QDir>
 #include <QFileInfo>
 
+namespace {
+int defaultBatchSize() {
+    bool ok = false;
+    const int configured = qEnvironmentVariableIntValue("IMGCOMPRESS_BATCH_SIZE", &ok);
+    return ok ? qMax(0, configured) : 16;
+}
+
+int defaultAbortPercent() {
+    bool ok = false;
+    const int configured = qEnvironmentVariableIntValue("IMGCOMPRESS_ABORT_PERCENT", &ok);
+    return ok ? qMax(0, configured) : 100;
+}
+}
+
 CompressController::CompressController(QObject *parent)
-    : QObject(parent), running(false), thread(nullptr), worker(nullptr) {}
+    : QObject(parent),
+      running(false),
+      thread(nullptr),
+      worker(nullptr),
+      watcher(new FolderWatcher(this)),
+      watchBusy(false) {
+    connect(watcher, &FolderWatcher::filesReady, this, [this](const QStringList &files) {
+        for (const QString &file : files) {
+            if (!watchQueue.contains(file)) {
+                watchQueue.append(file);
+            }
+        }
+        dispatchWatched();
+    });
+}
 
 void CompressController::start(
     const QString &inputDir,
     const QString &outputDir,
     const QStringList &formats,
+    const QVector<WalkedFile> &scannedFiles,
     bool lossless,
     int quality,
     const QString &profile,
@@ -45,13 +74,13 @@ void CompressController::start(
             return;
         }
     }
-    CompressionOptions options{lossless, quality, profile, outputFormat, concurrency, resizeEnabled, targetWidth, targetHeight, resizeMode};
+    CompressionOptions options{lossless, quality, profile, outputFormat, concurrency, resizeEnabled, targetWidth, targetHeight, resizeMode, defaultBatchSize(), defaultAbortPercent()};
     thread = new QThread(this);
     worker = new CompressWorker();
-    worker->configure(inputText, outputText, formats, options);
+    worker->configure(inputText, outputText, formats, options, scannedFiles);
     worker->moveToThread(thread);
     connect(thread, &QThread::started, worker, &CompressWorker::run);
-    connect(worker, &CompressWorker::logMessage, this, &CompressController::logMessage);
+    connect(worker, &CompressWorker::logRecords, this, &CompressController::logRecords);
     connect(worker, &CompressWorker::progressChanged, this, &CompressController::progressChanged);
     connect(worker, &CompressWorker::finished, this, [this](int, qint64, qint64, qint64) {
         running = false;
@@ -91,9 +120,8 @@ void CompressController::startFiles(
     }
     QStringList validFiles;
     for (const QString &file : files) {
-        QFileInfo info(file);
-        if (info.exists() && info.isFile()) {
-            validFiles.append(info.absoluteFilePath());
+        if (!file.isEmpty()) {
+            validFiles.append(QFileInfo(file).absoluteFilePath());
         }
     }
     if (validFiles.isEmpty()) {
@@ -121,13 +149,13 @@ void CompressController::startFiles(
             return;
         }
     }
-    CompressionOptions options{lossless, quality, profile, outputFormat, concurrency, resizeEnabled, targetWidth, targetHeight, resizeMode};
+    CompressionOptions options{lossless, quality, profile, outputFormat, concurrency, resizeEnabled, targetWidth, targetHeight, resizeMode, defaultBatchSize(), defaultAbortPercent()};
     thread = new QThread(this);
     worker = new CompressWorker();
     worker->configureFiles(validFiles, baseText, outputText, formats, options);
     worker->moveToThread(thread);
     connect(thread, &QThread::started, worker, &CompressWorker::run);
-    connect(worker, &CompressWorker::logMessage, this, &CompressController::logMessage);
+    connect(worker, &CompressWorker::logRecords, this, &CompressController::logRecords);
     connect(worker, &CompressWorker::progressChanged, this, &CompressController::progressChanged);
     connect(worker, &CompressWorker::finished, this, [this](int, qint64, qint64, qint64) {
         running = false;
@@ -145,3 +173,106 @@ void CompressController::startFiles(
     running = true;
     thread->start();
 }
+
+void CompressController::startWatching(
+    const QString &inputDir,
+    const QString &outputDir,
+    const QStringList &formats,
+    bool lossless,
+    int quality,
+    const QString &profile,
+    const QString &outputFormat,
+    int concurrency,
+    bool resizeEnabled,
+    int targetWidth,
+    int targetHeight,
+    int resizeMode
+) {
+    if (running) {
+        emit logMessage("已有任务进行中");
+        return;
+    }
+    const QString inputText = inputDir.trimmed();
+    const QString outputText = outputDir.trimmed();
+    if (inputText.isEmpty() || !QDir(inputText).exists()) {
+        emit logMessage("请输入有效的输入目录");
+        return;
+    }
+    if (outputText.isEmpty() || QDir(outputText).absolutePath() == QDir(inputText).absolutePath()) {
+        emit logMessage("监听模式需要设置与输入目录不同的输出目录");
+        return;
+    }
+    if (formats.isEmpty()) {
+        emit logMessage("请选择至少一种格式");
+        return;
+    }
+    QDir outputRoot(outputText);
+    if (!outputRoot.exists()) {
+        if (!outputRoot.mkpath(".")) {
+            emit logMessage("无法创建输出目录");
+            return;
+        }
+    }
+    if (!watcher->start(inputText, outputText, formats)) {
+        emit logMessage("无法监听输入目录");
+        return;
+    }
+    CompressionOptions options{lossless, quality, profile, outputFormat, concurrency, resizeEnabled, targetWidth, targetHeight, resizeMode, defaultBatchSize(), defaultAbortPercent()};
+    thread = new QThread(this);
+    worker = new CompressWorker();
+    worker->configureFiles(QStringList(), inputText, outputText, formats, options);
+    worker->moveToThread(thread);
+    connect(worker, &CompressWorker::logRecords, this, &CompressController::logRecords);
+    connect(worker, &CompressWorker::progressChanged, this, &CompressController::progressChanged);
+    connect(worker, &CompressWorker::finished, this, [this](int, qint64, qint64, qint64) {
+        watchBusy = false;
+        if (watcher->isActive()) {
+            dispatchWatched();
+        } else if (thread) {
+            thread->quit();
+        }
+    });
+    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    connect(thread, &QThread::finished, this, [this]() {
+        thread = nullptr;
+        worker = nullptr;
+        running = false;
+        emit finished();
+    });
+    running = true;
+    watchQueue.clear();
+    watchBusy = false;
+    thread->start();
+    emit logMessage(QString("开始监听 %1，新图片稳定后自动压缩").arg(inputText));
+    emit watchingChanged(true);
+}
+
+void CompressController::stopWatching() {
+    if (!watcher->isActive()) {
+        return;
+    }
+    watcher->stop();
+    watchQueue.clear();
+    emit logMessage("已停止监听");
+    emit watchingChanged(false);
+    if (!watchBusy && thread) {
+        thread->quit();
+    }
+}
+
+bool CompressController::isWatching() const {
+    return watcher->isActive();
+}
+
+void CompressController::dispatchWatched() {
+    if (watchBusy || watchQueue.isEmpty() || !worker) {
+        return;
+    }
+    const QStringList files = watchQueue;
+    watchQueue.clear();
+    watchBusy = true;
+    QMetaObject::invokeMethod(worker, [target = worker, files]() {
+        target->runFiles(files);
+    }, Qt::QueuedConnection);
+}
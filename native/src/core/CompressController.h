@@ -4,9 +4,13 @@
 #include <QString>
 #include <QStringList>
 #include <QThread>
+#include <QVector>
 
 #include "engine/EngineRegistry.h"
 #include "core/CompressWorker.h"
+#include "core/DirectoryWalker.h"
+#include "core/LogRecord.h"
+#include "core/FolderWatcher.h"
 
 class CompressController final : public QObject {
     Q_OBJECT
@@ -18,6 +22,7 @@ public:
         const QString &inputDir,
         const QString &outputDir,
         const QStringList &formats,
+        const QVector<WalkedFile> &scannedFiles,
         bool lossless,
         int quality,
         const QString &profile,
@@ -43,14 +48,37 @@ public:
         int targetHeight,
         int resizeMode
     );
+    void startWatching(
+        const QString &inputDir,
+        const QString &outputDir,
+        const QStringList &formats,
+        bool lossless,
+        int quality,
+        const QString &profile,
+        const QString &outputFormat,
+        int concurrency,
+        bool resizeEnabled,
+        int targetWidth,
+        int targetHeight,
+        int resizeMode
+    );
+    void stopWatching();
+    bool isWatching() const;
 
 signals:
     void logMessage(const QString &message);
+    void logRecords(const QVector<LogRecord> &records);
     void progressChanged(int percent);
     void finished();
+    void watchingChanged(bool watching);
 
 private:
+    void dispatchWatched();
+
     bool running;
     QThread *thread;
     CompressWorker *worker;
+    FolderWatcher *watcher;
+    QStringList watchQueue;
+    bool watchBusy;
 };
@@ -0,0 +1,161 @@
+#include "CompressManifest.h"
+
+#include <cstring>
+
+namespace {
+const char kMagic[8] = {'I', 'M', 'G', 'C', 'M', 'F', '0', '1'};
+const quint64 kInitialCapacity = 4096;
+
+struct ManifestHeader {
+    char magic[8];
+    quint64 capacity;
+    quint64 count;
+    quint64 reserved;
+};
+
+qint64 fileBytes(quint64 capacity) {
+    return static_cast<qint64>(sizeof(ManifestHeader) + capacity * sizeof(ManifestEntry));
+}
+
+quint64 slotKey(quint64 pathHash) {
+    return pathHash == 0 ? 1 : pathHash;
+}
+
+ManifestHeader *headerOf(uchar *mapped) {
+    return reinterpret_cast<ManifestHeader *>(mapped);
+}
+
+ManifestEntry *slotsOf(uchar *mapped) {
+    return reinterpret_cast<ManifestEntry *>(mapped + sizeof(ManifestHeader));
+}
+
+ManifestEntry *locate(uchar *mapped, quint64 key) {
+    const quint64 mask = headerOf(mapped)->capacity - 1;
+    ManifestEntry *slots = slotsOf(mapped);
+    quint64 index = key & mask;
+    while (slots[index].pathHash != 0 && slots[index].pathHash != key) {
+        index = (index + 1) & mask;
+    }
+    return &slots[index];
+}
+
+void place(uchar *mapped, const ManifestEntry &entry) {
+    const quint64 key = slotKey(entry.pathHash);
+    ManifestEntry *slot = locate(mapped, key);
+    if (slot->pathHash == 0) {
+        headerOf(mapped)->count += 1;
+    }
+    *slot = entry;
+    slot->pathHash = key;
+}
+}
+
+CompressManifest::CompressManifest(const QString &manifestPath) : path(manifestPath), mapped(nullptr) {}
+
+CompressManifest::~CompressManifest() {
+    close();
+}
+
+bool CompressManifest::open() {
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    const qint64 existing = file.size();
+    if (existing >= fileBytes(0)) {
+        mapped = file.map(0, existing);
+    }
+    if (mapped) {
+        const ManifestHeader *header = headerOf(mapped);
+        const quint64 capacity = header->capacity;
+        const bool valid = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0
+            && capacity >= kInitialCapacity
+            && (capacity & (capacity - 1)) == 0
+            && fileBytes(capacity) == existing
+            && header->count < capacity;
+        if (valid) {
+            return true;
+        }
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    if (!create(&file, kInitialCapacity)) {
+        return false;
+    }
+    mapped = file.map(0, fileBytes(kInitialCapacity));
+    return mapped != nullptr;
+}
+
+ManifestEntry *CompressManifest::find(quint64 pathHash) {
+    if (!mapped) {
+        return nullptr;
+    }
+    ManifestEntry *slot = locate(mapped, slotKey(pathHash));
+    return slot->pathHash == 0 ? nullptr : slot;
+}
+
+bool CompressManifest::insert(const ManifestEntry &entry) {
+    if (!mapped) {
+        return false;
+    }
+    const ManifestHeader *header = headerOf(mapped);
+    if ((header->count + 1) * 4 > header->capacity * 3 && !grow()) {
+        return false;
+    }
+    place(mapped, entry);
+    return true;
+}
+
+bool CompressManifest::create(QFile *target, quint64 capacity) {
+    if (!target->resize(0) || !target->resize(fileBytes(capacity))) {
+        return false;
+    }
+    uchar *fresh = target->map(0, fileBytes(capacity));
+    if (!fresh) {
+        return false;
+    }
+    ManifestHeader *header = headerOf(fresh);
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->capacity = capacity;
+    header->count = 0;
+    header->reserved = 0;
+    target->unmap(fresh);
+    return true;
+}
+
+bool CompressManifest::grow() {
+    const quint64 capacity = headerOf(mapped)->capacity;
+    const QString nextPath = path + ".tmp";
+    QFile next(nextPath);
+    if (!next.open(QIODevice::ReadWrite) || !create(&next, capacity * 2)) {
+        return false;
+    }
+    uchar *target = next.map(0, fileBytes(capacity * 2));
+    if (!target) {
+        next.close();
+        QFile::remove(nextPath);
+        return false;
+    }
+    const ManifestEntry *slots = slotsOf(mapped);
+    for (quint64 i = 0; i < capacity; i += 1) {
+        if (slots[i].pathHash != 0) {
+            place(target, slots[i]);
+        }
+    }
+    next.unmap(target);
+    next.close();
+    close();
+    QFile::remove(path);
+    if (!QFile::rename(nextPath, path)) {
+        return false;
+    }
+    return open();
+}
+
+void CompressManifest::close() {
+    if (mapped) {
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    file.close();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+struct ManifestEntry {
+    quint64 pathHash;
+    quint64 contentHash;
+    qint64 size;
+    qint64 mtimeMs;
+    quint64 optionsHash;
+    quint32 engineHash;
+    qint32 outputIndex;
+};
+
+class CompressManifest {
+public:
+    explicit CompressManifest(const QString &path);
+    ~CompressManifest();
+
+    bool open();
+    ManifestEntry *find(quint64 pathHash);
+    bool insert(const ManifestEntry &entry);
+
+private:
+    bool create(QFile *target, quint64 capacity);
+    bool grow();
+    void close();
+
+    QString path;
+    QFile file;
+    uchar *mapped;
+};
@@ -1,115 +1,267 @@
 #include "CompressWorker.h"
 
+#include "AdmissionController.h"
+#include "CompressManifest.h"
+#include "DirectoryWalker.h"
+#include "FileClone.h"
+#include "MpscChannel.h"
+#include "OutputPlanner.h"
+#include "engine/CompressionPlan.h"
+#include "engine/CpuBudget.h"
+#include "engine/FastHash.h"
+#include "engine/ImageProbe.h"
+#include "engine/OutputCache.h"
+#include "engine/Task.h"
+#include "engine/ToolCatalog.h"
+
 #include <QDateTime>
 #include <QDir>
-#include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
 #include <QImage>
 #include <QImageReader>
-#include <QImageWriter>
 #include <QHash>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QSet>
 #include <QThread>
 #include <QThreadPool>
-#include <QTemporaryFile>
-#include <QScopedPointer>
 #include <QVector>
-#include <QWaitCondition>
 #include <QQueue>
+#include <QSharedPointer>
 #include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
 
 namespace {
-QString ensureUniquePath(const QString &candidate, const QString &sourcePath, const QString &stem, const QString &suffix) {
-    const QFileInfo candidateInfo(candidate);
-    const QFileInfo sourceInfo(sourcePath);
-    const QString candidatePath = candidateInfo.absoluteFilePath();
-    const QString sourceAbsPath = sourceInfo.absoluteFilePath();
-    if (candidatePath != sourceAbsPath && !QFileInfo::exists(candidatePath)) {
-        return candidatePath;
-    }
-    const QString ext = suffix.isEmpty() ? QString() : "." + suffix;
-    QDir dir = candidateInfo.dir();
-    int index = 1;
-    while (true) {
-        const QString name = QString("%1(%2)%3").arg(stem).arg(index).arg(ext);
-        const QString nextPath = dir.filePath(name);
-        if (!QFileInfo::exists(nextPath) && nextPath != sourceAbsPath) {
-            return nextPath;
-        }
-        index += 1;
+const qint64 kBatchFileLimit = 512 * 1024;
+const int kScannedChunk = 512;
+const qint64 kRecordFlushMs = 100;
+const qint64 kMegabyte = 1024 * 1024;
+
+QString normalizeSuffix(const QString &suffix) {
+    if (suffix == "jpeg") {
+        return "jpg";
     }
+    return suffix;
 }
 
-int adjustQuality(int quality, const QString &profile) {
-    if (profile.contains("强")) {
-        return qMax(8, quality - 18);
+QString resolveTargetFormat(const QString &sourceSuffix, const CompressionOptions &options) {
+    const QString rawOutputFormat = options.outputFormat.toLower();
+    if (rawOutputFormat.isEmpty() || rawOutputFormat == "original") {
+        return sourceSuffix;
     }
-    if (profile.contains("均衡")) {
-        return qMax(10, quality - 10);
+    return normalizeSuffix(rawOutputFormat);
+}
+
+QString outputCandidate(
+    const QString &file,
+    const QDir &inputRoot,
+    const QDir &outputRoot,
+    const QString &targetFormat,
+    int index
+) {
+    const QFileInfo sourceInfo(file);
+    const QFileInfo relativeInfo(inputRoot.relativeFilePath(file));
+    const QString baseName = sourceInfo.completeBaseName();
+    const QString stem = index > 0 ? QString("%1(%2)").arg(baseName).arg(index) : baseName;
+    const QString relativeDir = relativeInfo.path();
+    const QString outputFileName = targetFormat.isEmpty() ? stem : stem + "." + targetFormat;
+    return relativeDir == "."
+        ? outputRoot.filePath(outputFileName)
+        : outputRoot.filePath(relativeDir + "/" + outputFileName);
+}
+
+int outputIndexOf(const QString &file, const QString &outputPath) {
+    const QString baseName = QFileInfo(file).completeBaseName();
+    const QString stem = QFileInfo(outputPath).completeBaseName();
+    if (stem.size() <= baseName.size() + 2 || !stem.startsWith(baseName + "(") || !stem.endsWith(")")) {
+        return 0;
     }
-    return quality;
+    return stem.mid(baseName.size() + 1, stem.size() - baseName.size() - 2).toInt();
 }
 
-QString normalizeSuffix(const QString &suffix) {
-    if (suffix == "jpeg") {
-        return "jpg";
+struct SourceStamp {
+    qint64 size;
+    qint64 mtimeMs;
+    quint64 contentHash;
+    bool valid;
+};
+
+SourceStamp stampSource(const QString &file) {
+    const QFileInfo info(file);
+    bool ok = false;
+    const quint64 contentHash = FastHash::hashFile(file, &ok);
+    return {info.size(), info.lastModified().toMSecsSinceEpoch(), contentHash, ok};
+}
+
+SourceStamp restampSource(const QString &file, const SourceStamp &known, bool hash) {
+    const QFileInfo info(file);
+    SourceStamp stamp{info.size(), info.lastModified().toMSecsSinceEpoch(), 0, false};
+    if (known.valid && known.size == stamp.size && known.mtimeMs == stamp.mtimeMs) {
+        stamp.contentHash = known.contentHash;
+        stamp.valid = true;
+    } else if (hash) {
+        stamp.contentHash = FastHash::hashFile(file, &stamp.valid);
     }
-    return suffix;
+    return stamp;
+}
+
+ImageInfo stampedInfo(const ImageInfo &info, const SourceStamp &stamp) {
+    ImageInfo stamped = info;
+    stamped.contentHash = stamp.contentHash;
+    stamped.hashed = stamp.valid && stamp.size == info.size;
+    return stamped;
+}
+
+quint64 pathKey(const QDir &inputRoot, const QString &file) {
+    const QByteArray relative = inputRoot.relativeFilePath(QFileInfo(file).absoluteFilePath()).toUtf8();
+    return FastHash::hash(relative.constData(), relative.size());
+}
+
+bool isUnchanged(
+    CompressManifest *manifest,
+    const QString &file,
+    const QDir &inputRoot,
+    const QDir &outputRoot,
+    const CompressionOptions &options,
+    quint64 optionsHash,
+    quint32 engineHash
+) {
+    ManifestEntry *entry = manifest->find(pathKey(inputRoot, file));
+    if (!entry || entry->optionsHash != optionsHash || entry->engineHash != engineHash) {
+        return false;
+    }
+    const QFileInfo info(file);
+    if (info.size() != entry->size) {
+        return false;
+    }
+    const QString targetFormat = resolveTargetFormat(normalizeSuffix(info.suffix().toLower()), options);
+    if (!QFileInfo::exists(outputCandidate(file, inputRoot, outputRoot, targetFormat, entry->outputIndex))) {
+        return false;
+    }
+    const qint64 mtimeMs = info.lastModified().toMSecsSinceEpoch();
+    if (mtimeMs == entry->mtimeMs) {
+        return true;
+    }
+    bool ok = false;
+    const quint64 contentHash = FastHash::hashFile(file, &ok);
+    if (!ok || contentHash != entry->contentHash) {
+        return false;
+    }
+    entry->mtimeMs = mtimeMs;
+    return true;
+}
+
+QVector<SourceStamp> stampAll(const QStringList &files) {
+    QVector<SourceStamp> stamps(files.size());
+    SourceStamp *target = stamps.data();
+    QThreadPool hashPool;
+    hashPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    const int chunk = qMax(1, static_cast<int>(files.size() / (hashPool.maxThreadCount() * 4)));
+    for (int begin = 0; begin < files.size(); begin += chunk) {
+        const int end = qMin(static_cast<int>(files.size()), begin + chunk);
+        hashPool.start([&files, target, begin, end]() {
+            for (int i = begin; i < end; i += 1) {
+                target[i] = stampSource(files[i]);
+            }
+        });
+    }
+    hashPool.waitForDone();
+    return stamps;
+}
+
+QVector<ImageInfo> probeAll(const QStringList &files) {
+    QVector<ImageInfo> infos(files.size());
+    ImageInfo *target = infos.data();
+    QThreadPool probePool;
+    probePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    const int chunk = qMax(1, static_cast<int>(files.size() / (probePool.maxThreadCount() * 4)));
+    for (int begin = 0; begin < files.size(); begin += chunk) {
+        const int end = qMin(static_cast<int>(files.size()), begin + chunk);
+        probePool.start([&files, target, begin, end]() {
+            for (int i = begin; i < end; i += 1) {
+                target[i] = ImageProbe::probe(files[i]);
+            }
+        });
+    }
+    probePool.waitForDone();
+    return infos;
+}
+
+QString contentKey(const SourceStamp &stamp, const QString &file) {
+    return QString("%1:%2:%3")
+        .arg(stamp.size)
+        .arg(stamp.contentHash, 16, 16, QChar('0'))
+        .arg(normalizeSuffix(QFileInfo(file).suffix().toLower()));
 }
 
 struct TaskOutcome {
     QString fileName;
     QString filePath;
+    QString outputPath;
+    SourceStamp source;
     CompressionResult result;
     bool hasResult;
-    QStringList logs;
+    QVector<LogRecord> logs;
     qint64 elapsedMs;
 };
 
-TaskOutcome compressSingle(
+TaskOutcome mirrorOutcome(
+    const TaskOutcome &leader,
     const QString &file,
-    const QDir &inputRoot,
-    const QDir &outputRoot,
-    const CompressionOptions &options
+    const QString &outputPath,
+    const SourceStamp &stamp
+) {
+    const QFileInfo sourceInfo(file);
+    TaskOutcome outcome;
+    outcome.fileName = sourceInfo.fileName();
+    outcome.filePath = sourceInfo.absoluteFilePath();
+    outcome.source = stamp;
+    outcome.hasResult = true;
+    outcome.elapsedMs = 0;
+    outcome.outputPath = outputPath;
+    const FileClone::Method method = FileClone::materialize(leader.outputPath, outcome.outputPath);
+    if (method == FileClone::Method::Failed) {
+        outcome.result = {false, sourceInfo.size(), sourceInfo.size(), leader.result.engine, "无法复用重复文件的压缩结果"};
+        return outcome;
+    }
+    outcome.result = leader.result;
+    outcome.result.originalSize = sourceInfo.size();
+    outcome.result.outputSize = QFileInfo(outcome.outputPath).size();
+    outcome.result.aborted = false;
+    outcome.result.cpuSavedMs = 0;
+    outcome.logs << LogRecord::message(QString("%1 与 %2 内容相同，已通过%3复用压缩结果")
+                        .arg(outcome.fileName, leader.fileName, FileClone::methodName(method)));
+    return outcome;
+}
+
+Task<TaskOutcome> compressSingle(
+    const QString &file,
+    const ImageInfo &info,
+    const QString &outputPath,
+    const CompressionPlan &plan,
+    CpuBudget *budget
 ) {
+    const CompressionOptions &options = plan.options;
     TaskOutcome outcome;
     const QFileInfo sourceInfo(file);
     outcome.fileName = sourceInfo.fileName();
     outcome.filePath = sourceInfo.absoluteFilePath();
-    const QString relativePath = inputRoot.relativeFilePath(file);
-    const QFileInfo relativeInfo(relativePath);
     const QString sourceSuffix = normalizeSuffix(sourceInfo.suffix().toLower());
-    const QByteArray detectedFormat = QImageReader::imageFormat(file);
-    const QString actualSuffix = normalizeSuffix(QString::fromLatin1(detectedFormat).toLower());
+    const QString actualSuffix = normalizeSuffix(info.format);
     const bool formatMismatch = !actualSuffix.isEmpty() && actualSuffix != sourceSuffix;
     const QString effectiveSuffix = actualSuffix.isEmpty() ? sourceSuffix : actualSuffix;
     if (formatMismatch) {
-        outcome.logs << QString("%1 实际格式为 %2，与扩展名 %3 不一致，将按实际格式压缩并保持文件名不变")
+        outcome.logs << LogRecord::warning(QString("%1 实际格式为 %2，与扩展名 %3 不一致，将按实际格式压缩并保持文件名不变")
                             .arg(sourceInfo.fileName())
                             .arg(actualSuffix)
-                            .arg(sourceSuffix);
-    }
-    const QString rawOutputFormat = options.outputFormat.toLower();
-    const QString normalizedOutputFormat = normalizeSuffix(rawOutputFormat);
-    const QString targetFormat = rawOutputFormat.isEmpty() || rawOutputFormat == "original"
-        ? sourceSuffix
-        : normalizedOutputFormat;
-    const QString baseName = sourceInfo.completeBaseName();
-    const QString relativeDir = relativeInfo.path();
-    const QString outputFileName = targetFormat.isEmpty() ? baseName : baseName + "." + targetFormat;
-    QString outputPath = relativeDir == "."
-        ? outputRoot.filePath(outputFileName)
-        : outputRoot.filePath(relativeDir + "/" + outputFileName);
-    outputPath = ensureUniquePath(outputPath, sourceInfo.absoluteFilePath(), baseName, targetFormat);
-    QFileInfo outputInfo(outputPath);
-    QDir outputDirInfo = outputInfo.dir();
-    if (!outputDirInfo.exists()) {
-        outputDirInfo.mkpath(".");
+                            .arg(sourceSuffix));
     }
-    const qint64 sourceSize = sourceInfo.size();
+    const QString targetFormat = resolveTargetFormat(sourceSuffix, options);
+    outcome.outputPath = outputPath;
+    const qint64 sourceSize = info.size;
     outcome.result = {false, sourceSize, sourceSize, "无", "失败"};
     outcome.hasResult = true;
     const bool convertToWebp = targetFormat == "webp" && effectiveSuffix != "webp";
@@ -117,66 +269,31 @@ TaskOutcome compressSingle(
     const bool convertFromWebp = effectiveSuffix == "webp"
         && (targetFormat == "jpg" || targetFormat == "png");
     if (convertToGif) {
-        outcome.logs << QString("%1 转换失败：不支持转换为GIF").arg(sourceInfo.fileName());
+        outcome.logs << LogRecord::message(QString("%1 转换失败：不支持转换为GIF").arg(sourceInfo.fileName()));
         outcome.hasResult = false;
-        return outcome;
+        co_return outcome;
     }
-    if (options.resizeEnabled && (effectiveSuffix == "webp" || targetFormat == "webp")) {
-        outcome.logs << QString("%1 转换失败：启用尺寸裁剪/缩放时不支持 WebP（需要 Qt WebP 插件）").arg(sourceInfo.fileName());
+    if (options.resizeEnabled && (effectiveSuffix == "webp" || targetFormat == "webp") && !EngineRegistry::canResizeWebp()) {
+        outcome.logs << LogRecord::message(QString("%1 转换失败：启用尺寸裁剪/缩放时不支持 WebP（需要内置 libwebp）").arg(sourceInfo.fileName()));
         outcome.hasResult = false;
-        return outcome;
+        co_return outcome;
     }
     if ((convertToWebp || convertFromWebp) && !options.resizeEnabled) {
-        outcome.result = EngineRegistry::compressFile(file, outputPath, options);
+        outcome.result = co_await EngineRegistry::compressFile(file, outputPath, plan, info, budget);
         if (!outcome.result.success) {
-            QImageReader reader(file);
-            reader.setAutoTransform(true);
-            if (!actualSuffix.isEmpty()) {
-                reader.setFormat(actualSuffix.toLatin1());
-            }
-            QImage image = reader.read();
+            QImage image = EngineRegistry::readImage(file, actualSuffix);
             if (!image.isNull()) {
-                QString tempFormat = !actualSuffix.isEmpty() ? actualSuffix : "png";
-                QScopedPointer<QTemporaryFile> temp(new QTemporaryFile(outputRoot.filePath(".imgcompress_tmp_XXXXXX." + tempFormat)));
-                temp->setAutoRemove(true);
-                if (!temp->open()) {
-                    temp.reset(new QTemporaryFile(QDir(QDir::tempPath()).filePath("imgcompress_tmp_XXXXXX." + tempFormat)));
-                    temp->setAutoRemove(true);
-                    if (!temp->open()) {
-                        outcome.logs << QString("%1 转换失败：无法创建临时文件").arg(sourceInfo.fileName());
-                        outcome.hasResult = false;
-                        return outcome;
-                    }
-                }
-                {
-                    const QString tempPath = temp->fileName();
-                    temp->close();
-                    QImageWriter writer(tempPath, tempFormat.toLatin1());
-                    const int quality = options.lossless
-                        ? 100
-                        : qBound(1, adjustQuality(options.quality, options.profile), 100);
-                    writer.setQuality(quality);
-                    if (writer.write(image)) {
-                        outcome.result = EngineRegistry::compressFile(tempPath, outputPath, options);
-                        if (!outcome.result.success) {
-                            QFile::remove(outputPath);
-                            QFile::copy(tempPath, outputPath);
-                            outcome.result = {true, sourceSize, QFileInfo(outputPath).size(), "Qt", "已转换"};
-                        } else {
-                            outcome.result.originalSize = sourceSize;
-                            outcome.result.outputSize = QFileInfo(outputPath).size();
-                        }
-                    } else {
-                        outcome.logs << QString("%1 转换失败：无法写入格式").arg(sourceInfo.fileName());
-                        outcome.hasResult = false;
-                        return outcome;
-                    }
+                outcome.result = co_await EngineRegistry::compressImage(image, outputPath, targetFormat, plan, sourceSize, budget);
+                if (!outcome.result.success) {
+                    outcome.logs << LogRecord::message(QString("%1 转换失败：无法写入格式").arg(sourceInfo.fileName()));
+                    outcome.hasResult = false;
+                    co_return outcome;
                 }
             }
         }
     } else if (options.resizeEnabled || targetFormat != effectiveSuffix || formatMismatch) {
         if (!options.resizeEnabled && formatMismatch) {
-            outcome.result = EngineRegistry::compressFile(file, outputPath, options);
+            outcome.result = co_await EngineRegistry::compressFile(file, outputPath, plan, info, budget);
             if (!outcome.result.success) {
                 QFile::remove(outputPath);
                 QFile::copy(file, outputPath);
@@ -186,20 +303,15 @@ TaskOutcome compressSingle(
                 outcome.result.outputSize = QFileInfo(outputPath).size();
             }
         } else {
-            QImageReader reader(file);
-            reader.setAutoTransform(true);
-            if (effectiveSuffix == "webp") {
-                reader.setFormat("webp");
-            }
-            QImage image = reader.read();
+            QImage image = EngineRegistry::readImage(file, effectiveSuffix == "webp" ? effectiveSuffix : QString());
             if (image.isNull()) {
                 if (effectiveSuffix == "webp") {
-                    outcome.logs << QString("%1 转换失败：WebP 解码不可用（缺少 dwebp 或 Qt WebP 插件）").arg(sourceInfo.fileName());
+                    outcome.logs << LogRecord::message(QString("%1 转换失败：WebP 解码不可用（缺少内置 libwebp 或 Qt WebP 插件）").arg(sourceInfo.fileName()));
                 } else {
-                    outcome.logs << QString("%1 转换失败：无法读取图片").arg(sourceInfo.fileName());
+                    outcome.logs << LogRecord::message(QString("%1 转换失败：无法读取图片").arg(sourceInfo.fileName()));
                 }
                 outcome.hasResult = false;
-                return outcome;
+                co_return outcome;
             }
             if (options.resizeEnabled) {
                 if (options.resizeMode == 2) {
@@ -223,60 +335,26 @@ TaskOutcome compressSingle(
                     );
                 }
             }
-            QString tempFormat = targetFormat;
-            bool allowTempFallback = true;
-            if (convertToWebp || convertToGif) {
-                tempFormat = effectiveSuffix.isEmpty() ? "png" : effectiveSuffix;
-                allowTempFallback = false;
-            }
-            QImageWriter writer(outputPath, tempFormat.toLatin1());
-            const int quality = options.lossless
-                ? 100
-                : qBound(1, adjustQuality(options.quality, options.profile), 100);
-            writer.setQuality(quality);
-            if (!writer.write(image)) {
-                outcome.logs << QString("%1 转换失败：无法写入格式").arg(sourceInfo.fileName());
+            outcome.result = co_await EngineRegistry::compressImage(image, outputPath, targetFormat, plan, sourceSize, budget);
+            if (!outcome.result.success) {
+                outcome.logs << LogRecord::message(QString("%1 转换失败：无法写入格式").arg(sourceInfo.fileName()));
                 outcome.hasResult = false;
-                return outcome;
+                co_return outcome;
             }
-            outcome.result = EngineRegistry::compressFile(outputPath, outputPath, options);
-            outcome.result.originalSize = sourceSize;
-            outcome.result.outputSize = QFileInfo(outputPath).size();
         }
     } else {
-        outcome.result = EngineRegistry::compressFile(file, outputPath, options);
+        outcome.result = co_await EngineRegistry::compressFile(file, outputPath, plan, info, budget);
         if (!outcome.result.success && effectiveSuffix == "jpg") {
             QImageReader reader(file);
             reader.setAutoTransform(true);
             QImage image = reader.read();
             if (!image.isNull()) {
-                const QString tempFormat = "jpg";
-                QScopedPointer<QTemporaryFile> temp(new QTemporaryFile(outputRoot.filePath(".imgcompress_tmp_XXXXXX." + tempFormat)));
-                temp->setAutoRemove(true);
-                if (!temp->open()) {
-                    temp.reset(new QTemporaryFile(QDir(QDir::tempPath()).filePath("imgcompress_tmp_XXXXXX." + tempFormat)));
-                    temp->setAutoRemove(true);
-                    if (!temp->open()) {
-                        outcome.logs << QString("%1 转换失败：无法创建临时文件").arg(sourceInfo.fileName());
-                        outcome.hasResult = false;
-                        return outcome;
-                    }
-                }
-                const QString tempPath = temp->fileName();
-                temp->close();
-                QImageWriter writer(tempPath, tempFormat.toLatin1());
-                const int quality = options.lossless
-                    ? 100
-                    : qBound(1, adjustQuality(options.quality, options.profile), 100);
-                writer.setQuality(quality);
-                if (writer.write(image)) {
-                    QFile::remove(outputPath);
-                    QFile::copy(tempPath, outputPath);
+                if (EngineRegistry::writeImage(image, outputPath, "jpg", plan.encodeQuality)) {
                     outcome.result = {true, sourceSize, QFileInfo(outputPath).size(), "Qt", "已压缩"};
                 } else {
-                    outcome.logs << QString("%1 转换失败：无法写入格式").arg(sourceInfo.fileName());
+                    outcome.logs << LogRecord::message(QString("%1 转换失败：无法写入格式").arg(sourceInfo.fileName()));
                     outcome.hasResult = false;
-                    return outcome;
+                    co_return outcome;
                 }
             }
         }
@@ -288,65 +366,137 @@ TaskOutcome compressSingle(
         outcome.result.engine = "原图";
         outcome.result.message = "已保留原图";
     }
-    return outcome;
+    co_return outcome;
 }
 
-class CompressTask final : public QRunnable {
-public:
-    CompressTask(
-        const QString &file,
-        const QDir &inputRoot,
-        const QDir &outputRoot,
-        const CompressionOptions &options,
-        QQueue<TaskOutcome> *queue,
-        QMutex *mutex,
-        QWaitCondition *condition
-    )
-        : filePath(file),
-          input(inputRoot),
-          output(outputRoot),
-          opts(options),
-          resultQueue(queue),
-          queueMutex(mutex),
-          queueCondition(condition) {
-        setAutoDelete(true);
-    }
-
-    void run() override {
+struct PendingFile {
+    QString path;
+    QString outputPath;
+    ImageInfo info;
+    SourceStamp stamp;
+    double cost;
+    ResourceEstimate memory;
+};
+
+struct PendingJob {
+    QVector<PendingFile> files;
+    double cost;
+    int sequence;
+    ResourceEstimate memory;
+    bool deferred;
+};
+
+struct JobContext {
+    CompressionPlan plan;
+    MpscChannel<TaskOutcome> *outcomes;
+    bool hashSources;
+    CpuBudget *budget;
+};
+
+Task<void> compressJob(QSharedPointer<const JobContext> context, PendingFile file) {
+    const QDateTime started = QDateTime::currentDateTime();
+    context->budget->enter();
+    const SourceStamp stamp = restampSource(file.path, file.stamp, context->hashSources);
+    const ImageInfo info = stampedInfo(file.info, stamp);
+    TaskOutcome finished = co_await compressSingle(file.path, info, file.outputPath, context->plan, context->budget);
+    context->budget->leave();
+    finished.source = stamp;
+    finished.elapsedMs = started.msecsTo(QDateTime::currentDateTime());
+    context->outcomes->push(std::move(finished));
+}
+
+Task<void> compressBatchJob(QSharedPointer<const JobContext> context, QVector<PendingFile> files) {
+    const CompressionPlan &taskPlan = context->plan;
+    context->budget->enter();
+    QVector<TaskOutcome> finished;
+    QStringList sources;
+    QStringList outputs;
+    QVector<SourceStamp> stamps;
+    QVector<ImageInfo> infos;
+    for (const PendingFile &file : files) {
+        const SourceStamp stamp = restampSource(file.path, file.stamp, context->hashSources);
+        const ImageInfo info = stampedInfo(file.info, stamp);
+        const QString sourceSuffix = normalizeSuffix(QFileInfo(file.path).suffix().toLower());
+        const QString actualSuffix = normalizeSuffix(file.info.format);
+        if (!actualSuffix.isEmpty() && actualSuffix != sourceSuffix) {
+            const QDateTime started = QDateTime::currentDateTime();
+            TaskOutcome outcome = co_await compressSingle(file.path, info, file.outputPath, taskPlan, context->budget);
+            outcome.source = stamp;
+            outcome.elapsedMs = started.msecsTo(QDateTime::currentDateTime());
+            finished.append(outcome);
+            continue;
+        }
+        sources.append(file.path);
+        outputs.append(file.outputPath);
+        stamps.append(stamp);
+        infos.append(info);
+    }
+    if (!sources.isEmpty()) {
         const QDateTime started = QDateTime::currentDateTime();
-        const TaskOutcome outcome = compressSingle(filePath, input, output, opts);
-        TaskOutcome finished = outcome;
-        finished.elapsedMs = started.msecsTo(QDateTime::currentDateTime());
-        QMutexLocker locker(queueMutex);
-        resultQueue->enqueue(finished);
-        queueCondition->wakeOne();
+        const QVector<CompressionResult> results = co_await EngineRegistry::compressBatch(sources, outputs, taskPlan, infos, context->budget);
+        const qint64 elapsedMs = started.msecsTo(QDateTime::currentDateTime()) / sources.size();
+        for (int i = 0; i < sources.size(); i += 1) {
+            const QFileInfo sourceInfo(sources[i]);
+            TaskOutcome outcome;
+            outcome.fileName = sourceInfo.fileName();
+            outcome.filePath = sourceInfo.absoluteFilePath();
+            outcome.outputPath = outputs[i];
+            outcome.source = stamps[i];
+            outcome.result = results.value(i, {false, infos[i].size, infos[i].size, "无", "失败"});
+            outcome.hasResult = true;
+            outcome.elapsedMs = elapsedMs;
+            finished.append(outcome);
+        }
+    }
+    context->budget->leave();
+    for (TaskOutcome &outcome : finished) {
+        context->outcomes->push(std::move(outcome));
     }
+}
 
-private:
-    QString filePath;
-    QDir input;
-    QDir output;
-    CompressionOptions opts;
-    QQueue<TaskOutcome> *resultQueue;
-    QMutex *queueMutex;
-    QWaitCondition *queueCondition;
-};
+bool lowerPriority(const PendingJob &a, const PendingJob &b) {
+    return a.cost < b.cost || (a.cost == b.cost && a.sequence > b.sequence);
+}
+
+qint64 listScheduleTail(const QVector<qint64> &durations, int workers) {
+    std::priority_queue<qint64, std::vector<qint64>, std::greater<qint64>> freeAt;
+    for (int i = 0; i < workers; i += 1) {
+        freeAt.push(0);
+    }
+    for (const qint64 duration : durations) {
+        const qint64 start = freeAt.top();
+        freeAt.pop();
+        freeAt.push(start + duration);
+    }
+    const qint64 firstIdle = freeAt.top();
+    qint64 makespan = firstIdle;
+    while (!freeAt.empty()) {
+        makespan = freeAt.top();
+        freeAt.pop();
+    }
+    return makespan - firstIdle;
+}
 }
 
-CompressWorker::CompressWorker(QObject *parent) : QObject(parent), useFileList(false) {}
+CompressWorker::CompressWorker(QObject *parent) : QObject(parent), useFileList(false), watchDispatch(false) {
+    pool.setExpiryTimeout(-1);
+}
 
 void CompressWorker::configure(
     const QString &inputDirValue,
     const QString &outputDirValue,
     const QStringList &formatsValue,
-    const CompressionOptions &optionsValue
+    const CompressionOptions &optionsValue,
+    const QVector<WalkedFile> &scannedFilesValue
 ) {
     inputDir = inputDirValue;
     outputDir = outputDirValue;
     formats = formatsValue;
     options = optionsValue;
     files.clear();
+    scannedFiles = scannedFilesValue;
     useFileList = false;
+    watchDispatch = false;
 }
 
 void CompressWorker::configureFiles(
@@ -361,74 +511,439 @@ void CompressWorker::configureFiles(
     formats = formatsValue;
     options = optionsValue;
     files = filesValue;
+    scannedFiles.clear();
     useFileList = true;
+    watchDispatch = false;
 }
 
-void CompressWorker::run() {
-    QStringList filters;
-    for (const QString &fmt : formats) {
-        filters << QString("*.%1").arg(fmt.toLower());
-    }
-    QStringList workingFiles;
-    QSet<QString> formatSet;
-    for (const QString &fmt : formats) {
-        formatSet.insert(fmt.toLower());
-    }
-    if (useFileList) {
-        for (const QString &file : files) {
-            const QString suffix = QFileInfo(file).suffix().toLower();
-            if (formatSet.contains(suffix)) {
-                workingFiles.append(file);
-            }
-        }
-    } else {
-        QDirIterator it(inputDir, filters, QDir::Files, QDirIterator::Subdirectories);
-        while (it.hasNext()) {
-            workingFiles.append(it.next());
-        }
+void CompressWorker::runFiles(const QStringList &filesValue) {
+    files = filesValue;
+    useFileList = true;
+    watchDispatch = true;
+    run();
+}
+
+void CompressWorker::log(const QString &message) {
+    record(LogRecord::message(message));
+}
+
+void CompressWorker::record(const LogRecord &entry) {
+    if (records.isEmpty()) {
+        recordTimer.start();
     }
-    if (workingFiles.isEmpty()) {
-        emit logMessage("未找到可压缩图片");
-        emit finished(0, 0, 0, 0);
+    records.append(entry);
+}
+
+void CompressWorker::publishRecords(bool force) {
+    if (records.isEmpty() || (!force && recordTimer.elapsed() < kRecordFlushMs)) {
         return;
     }
-    emit logMessage(QString("开始压缩 %1 张图片").arg(workingFiles.size()));
+    emit logRecords(records);
+    records.clear();
+}
+
+void CompressWorker::run() {
+    QStringList suffixes;
+    for (const QString &fmt : formats) {
+        suffixes.append(fmt.toLower());
+    }
+    ToolCatalog::refresh();
+    const CompressionPlan plan = CompressionPlanner::compile(options);
+    QDir inputRoot(inputDir);
+    QDir outputRoot(outputDir);
+    outputRoot.mkpath(".");
+    CompressManifest manifest(outputRoot.filePath(".imgcompress_manifest"));
+    const bool manifestReady = manifest.open();
+    const quint64 optionsHash = EngineRegistry::optionsFingerprint(options);
+    const QByteArray engine = EngineRegistry::engineSignature().toUtf8();
+    const quint64 engineFingerprint = FastHash::hash(engine.constData(), engine.size());
+    const quint32 engineHash = static_cast<quint32>(engineFingerprint);
+    OutputCache::configure(
+        qEnvironmentVariable("IMGCOMPRESS_CACHE_DIR"),
+        qEnvironmentVariableIntValue("IMGCOMPRESS_CACHE_MB"),
+        engineFingerprint
+    );
+    OutputPlanner outputPlanner(inputRoot, outputRoot);
     const QDateTime started = QDateTime::currentDateTime();
     int successCount = 0;
+    int abortedCount = 0;
+    qint64 cpuSavedMs = 0;
     qint64 totalBefore = 0;
     qint64 totalAfter = 0;
-    QDir inputRoot(inputDir);
-    QDir outputRoot(outputDir);
     int completed = 0;
-    QThreadPool pool;
-    int concurrency = options.concurrency;
-    if (concurrency < 1) {
-        const int ideal = QThread::idealThreadCount();
-        concurrency = ideal > 1 ? ideal - 1 : 1;
-    }
-    pool.setMaxThreadCount(concurrency);
-    QQueue<TaskOutcome> outcomes;
-    QMutex queueMutex;
-    QWaitCondition queueCondition;
+    int total = 0;
+    int discoveredCount = 0;
+    int skippedCount = 0;
+    int duplicateCount = 0;
+    int lastPercent = 0;
+    const int cores = qMax(1, QThread::idealThreadCount());
+    const int concurrency = options.concurrency > 0 ? options.concurrency : cores;
+    pool.setMaxThreadCount(cores);
+    CpuBudget budget(cores, concurrency);
+    MpscChannel<TaskOutcome> outcomes;
+    const QSharedPointer<const JobContext> context(new JobContext{plan, &outcomes, manifestReady || OutputCache::isEnabled(), &budget});
+    bool memoryConfigured = false;
+    const int memoryMb = qEnvironmentVariableIntValue("IMGCOMPRESS_MEMORY_MB", &memoryConfigured);
+    AdmissionController admission(memoryConfigured ? qMax(0, memoryMb) * kMegabyte : AdmissionController::defaultBudget());
+    QVector<QVector<PendingJob>> ready(2);
+    int deferredJobs = 0;
+    int runningJobs = 0;
+    QVector<qint64> jobDurations;
+    QHash<QString, int> jobOfFile;
+    QHash<int, int> jobRemaining;
+    QDateTime tailStarted;
+    QQueue<QVector<WalkedFile>> discovered;
+    bool enumerated = false;
+    bool flushed = false;
+    QMutex discoveryMutex;
+    DirectoryWalker walker(
+        suffixes,
+        [&discovered, &discoveryMutex, &outcomes](const QVector<WalkedFile> &found) {
+            QMutexLocker locker(&discoveryMutex);
+            discovered.enqueue(found);
+            outcomes.notify();
+        },
+        [&enumerated, &discoveryMutex, &outcomes]() {
+            QMutexLocker locker(&discoveryMutex);
+            enumerated = true;
+            outcomes.notify();
+        }
+    );
     QHash<QString, QDateTime> activeTasks;
+    QSet<QString> pendingFiles;
     QDateTime lastHeartbeat = QDateTime::currentDateTime();
-    for (const QString &file : workingFiles) {
-        pool.start(new CompressTask(file, inputRoot, outputRoot, options, &outcomes, &queueMutex, &queueCondition));
-        activeTasks.insert(file, QDateTime::currentDateTime());
+    QHash<QString, bool> batchableFormats;
+    QHash<QString, QVector<PendingFile>> batches;
+    QHash<qint64, QString> sizeLeaders;
+    QHash<QString, QString> contentLeaders;
+    QHash<QString, QString> leaderKeys;
+    QHash<QString, QStringList> duplicates;
+    QHash<QString, SourceStamp> duplicateStamps;
+    QHash<QString, QString> copyOutputs;
+    QSet<QString> plannedOutputs;
+    const QString inputRootPath = QDir::cleanPath(inputRoot.absolutePath());
+    const QString outputRootPath = QDir::cleanPath(outputRoot.absolutePath());
+    const QString excludedRoot = !useFileList && outputRootPath != inputRootPath ? outputRootPath : QString();
+    walker.setExcluded(excludedRoot);
+
+    auto enqueueJob = [&](const QVector<PendingFile> &jobFiles) {
+        PendingJob job{jobFiles, 0.0, static_cast<int>(jobDurations.size()), {ResourceClass::Light, 0}, false};
+        for (const PendingFile &file : jobFiles) {
+            job.cost += file.cost;
+            if (file.memory.resourceClass == ResourceClass::Heavy) {
+                job.memory.resourceClass = ResourceClass::Heavy;
+            }
+            job.memory.bytes = qMax(job.memory.bytes, file.memory.bytes);
+        }
+        jobDurations.append(0);
+        QVector<PendingJob> &queue = ready[job.memory.resourceClass == ResourceClass::Heavy ? 1 : 0];
+        queue.append(job);
+        std::push_heap(queue.begin(), queue.end(), lowerPriority);
+    };
+    auto pendingFile = [&](const QString &file, const QString &outputPath, const ImageInfo &info, const SourceStamp &stamp) {
+        const QString suffix = QFileInfo(file).suffix().toLower();
+        return PendingFile{
+            file,
+            outputPath,
+            info,
+            stamp,
+            CompressionPlanner::estimateCost(plan, info, suffix),
+            CompressionPlanner::estimateMemory(plan, info, suffix)
+        };
+    };
+    auto flushBatch = [&](const QString &suffix, bool all) {
+        QVector<PendingFile> &group = batches[suffix];
+        while (group.size() >= options.batchSize || (all && !group.isEmpty())) {
+            const int size = qMin(static_cast<int>(group.size()), options.batchSize);
+            enqueueJob(group.mid(0, size));
+            group.remove(0, size);
+        }
+    };
+    auto refill = [&]() {
+        while (runningJobs < concurrency) {
+            QVector<PendingJob> *next = nullptr;
+            for (QVector<PendingJob> &queue : ready) {
+                if (queue.isEmpty()) {
+                    continue;
+                }
+                if (!admission.fits(queue.first().memory)) {
+                    if (!queue.first().deferred) {
+                        queue.first().deferred = true;
+                        deferredJobs += 1;
+                    }
+                    continue;
+                }
+                if (!next || lowerPriority(next->first(), queue.first())) {
+                    next = &queue;
+                }
+            }
+            if (!next) {
+                break;
+            }
+            std::pop_heap(next->begin(), next->end(), lowerPriority);
+            const PendingJob job = next->takeLast();
+            admission.acquire(job.sequence, job.memory);
+            if (job.files.size() == 1) {
+                Task<void>::start(&pool, compressJob(context, job.files.first()));
+            } else {
+                Task<void>::start(&pool, compressBatchJob(context, job.files));
+            }
+            runningJobs += 1;
+            jobRemaining.insert(job.sequence, job.files.size());
+            const QDateTime now = QDateTime::currentDateTime();
+            for (const PendingFile &file : job.files) {
+                activeTasks.insert(file.path, now);
+                jobOfFile.insert(file.path, job.sequence);
+            }
+        }
+    };
+    auto dispatch = [&](const WalkedFile &file, const QString &outputPath, const ImageInfo &info, const SourceStamp &stamp) {
+        pendingFiles.insert(file.path);
+        const QString suffix = normalizeSuffix(QFileInfo(file.path).suffix().toLower());
+        bool batchable = options.batchSize > 1
+            && !options.resizeEnabled
+            && file.size <= kBatchFileLimit
+            && (suffix == "png" || suffix == "gif")
+            && resolveTargetFormat(suffix, options) == suffix;
+        if (batchable) {
+            if (!batchableFormats.contains(suffix)) {
+                batchableFormats.insert(suffix, EngineRegistry::canBatch(suffix, plan));
+            }
+            batchable = batchableFormats.value(suffix);
+        }
+        if (batchable) {
+            batches[suffix].append(pendingFile(file.path, outputPath, info, stamp));
+            flushBatch(suffix, false);
+        } else {
+            enqueueJob({pendingFile(file.path, outputPath, info, stamp)});
+        }
+    };
+    auto admit = [&](const QVector<WalkedFile> &found) {
+        QVector<WalkedFile> changed;
+        QStringList paths;
+        QStringList targetFormats;
+        QHash<QString, QString> recordedOutputs;
+        for (const WalkedFile &file : found) {
+            if (plannedOutputs.contains(file.path) || (!excludedRoot.isEmpty() && file.path.startsWith(excludedRoot + "/"))) {
+                continue;
+            }
+            discoveredCount += 1;
+            if (manifestReady && isUnchanged(&manifest, file.path, inputRoot, outputRoot, options, optionsHash, engineHash)) {
+                skippedCount += 1;
+                continue;
+            }
+            changed.append(file);
+            const QString targetFormat = resolveTargetFormat(normalizeSuffix(QFileInfo(file.path).suffix().toLower()), options);
+            const ManifestEntry *entry = watchDispatch && manifestReady ? manifest.find(pathKey(inputRoot, file.path)) : nullptr;
+            if (entry) {
+                const QString recorded = outputCandidate(file.path, inputRoot, outputRoot, targetFormat, entry->outputIndex);
+                if (QFileInfo::exists(recorded)) {
+                    recordedOutputs.insert(QFileInfo(file.path).absoluteFilePath(), recorded);
+                    continue;
+                }
+            }
+            paths.append(file.path);
+            targetFormats.append(targetFormat);
+        }
+        if (changed.isEmpty()) {
+            return;
+        }
+        total += changed.size();
+        OutputPlan outputs = outputPlanner.plan(paths, targetFormats);
+        outputs.paths.insert(recordedOutputs);
+        for (auto it = outputs.paths.constBegin(); it != outputs.paths.constEnd(); ++it) {
+            plannedOutputs.insert(it.value());
+        }
+        if (outputs.failedDirectories > 0) {
+            log(QString("%1 个输出目录创建失败，相关图片将无法写入").arg(outputs.failedDirectories));
+        }
+        QHash<qint64, int> sizeCounts;
+        for (const WalkedFile &file : changed) {
+            sizeCounts[file.size] += 1;
+        }
+        QStringList toHash;
+        QSet<qint64> collided;
+        for (const WalkedFile &file : changed) {
+            if (collided.contains(file.size) || (sizeCounts.value(file.size) < 2 && !sizeLeaders.contains(file.size))) {
+                continue;
+            }
+            collided.insert(file.size);
+            const QString earlier = sizeLeaders.value(file.size);
+            if (!earlier.isEmpty() && pendingFiles.contains(earlier)) {
+                toHash.append(earlier);
+            }
+        }
+        const int earlierCount = toHash.size();
+        QVector<int> hashIndex(changed.size(), -1);
+        for (int i = 0; i < changed.size(); i += 1) {
+            if (collided.contains(changed[i].size)) {
+                hashIndex[i] = toHash.size();
+                toHash.append(changed[i].path);
+            }
+        }
+        const QVector<SourceStamp> stamps = toHash.isEmpty() ? QVector<SourceStamp>() : stampAll(toHash);
+        for (int i = 0; i < earlierCount; i += 1) {
+            if (!stamps[i].valid) {
+                continue;
+            }
+            const QString key = contentKey(stamps[i], toHash[i]);
+            if (!contentLeaders.contains(key)) {
+                contentLeaders.insert(key, toHash[i]);
+                leaderKeys.insert(toHash[i], key);
+            }
+        }
+        QVector<int> leaders;
+        for (int i = 0; i < changed.size(); i += 1) {
+            const WalkedFile &file = changed[i];
+            const QString outputPath = outputs.outputFor(file.path);
+            if (hashIndex[i] < 0) {
+                sizeLeaders.insert(file.size, file.path);
+                leaders.append(i);
+                continue;
+            }
+            sizeLeaders.insert(file.size, QString());
+            const SourceStamp &stamp = stamps[hashIndex[i]];
+            if (!stamp.valid) {
+                leaders.append(i);
+                continue;
+            }
+            const QString key = contentKey(stamp, file.path);
+            const QString leader = contentLeaders.value(key);
+            if (!leader.isEmpty()) {
+                duplicates[leader].append(file.path);
+                duplicateStamps.insert(file.path, stamp);
+                copyOutputs.insert(file.path, outputPath);
+                duplicateCount += 1;
+                continue;
+            }
+            contentLeaders.insert(key, file.path);
+            leaderKeys.insert(file.path, key);
+            leaders.append(i);
+        }
+        QStringList leaderPaths;
+        leaderPaths.reserve(leaders.size());
+        for (const int index : leaders) {
+            leaderPaths.append(changed[index].path);
+        }
+        const QVector<ImageInfo> infos = probeAll(leaderPaths);
+        for (int i = 0; i < leaders.size(); i += 1) {
+            const WalkedFile &file = changed[leaders[i]];
+            const int hashed = hashIndex[leaders[i]];
+            dispatch(file, outputs.outputFor(file.path), infos[i], hashed >= 0 ? stamps[hashed] : SourceStamp{0, 0, 0, false});
+        }
+    };
+
+    log("开始压缩");
+    log("引擎计划（按已找到的引擎预估的首选路线，失败时按回退链执行，实际引擎以逐文件日志为准）：");
+    for (const QString &line : CompressionPlanner::describe(plan)) {
+        log(QString("  %1").arg(line));
     }
-    const int total = workingFiles.size();
-    while (completed < total) {
-        queueMutex.lock();
-        if (outcomes.isEmpty()) {
-            queueCondition.wait(&queueMutex, 2000);
+    if (admission.isEnabled()) {
+        log(QString("内存预算：%1 MB，解码/缩放与内置无损编码按估算峰值内存准入").arg(admission.budget() / kMegabyte));
+    }
+    if (useFileList) {
+        const QSet<QString> formatSet(suffixes.begin(), suffixes.end());
+        QVector<WalkedFile> listed;
+        for (const QString &file : files) {
+            const QFileInfo info(file);
+            if (formatSet.contains(info.suffix().toLower()) && info.isFile()) {
+                listed.append({info.absoluteFilePath(), info.size(), info.lastModified().toMSecsSinceEpoch()});
+            }
+        }
+        if (!listed.isEmpty()) {
+            discovered.enqueue(listed);
+        }
+        enumerated = true;
+    } else if (!scannedFiles.isEmpty()) {
+        const QSet<QString> formatSet(suffixes.begin(), suffixes.end());
+        QVector<WalkedFile> listed;
+        for (const WalkedFile &file : scannedFiles) {
+            const int dot = file.path.lastIndexOf('.');
+            if (dot > 0 && formatSet.contains(file.path.mid(dot + 1).toLower())) {
+                listed.append(file);
+                if (listed.size() >= kScannedChunk) {
+                    discovered.enqueue(listed);
+                    listed.clear();
+                }
+            }
+        }
+        if (!listed.isEmpty()) {
+            discovered.enqueue(listed);
+        }
+        scannedFiles.clear();
+        enumerated = true;
+        log("复用界面已完成的目录扫描结果，无需重新扫描");
+    } else {
+        log("正在扫描输入目录，已发现的图片会立即开始压缩");
+        walker.start({inputDir});
+    }
+    while (!flushed || completed < total) {
+        QVector<QVector<WalkedFile>> found;
+        discoveryMutex.lock();
+        bool walkDone = enumerated;
+        const bool discovering = !discovered.isEmpty() || (walkDone && !flushed);
+        discoveryMutex.unlock();
+        if (!discovering && outcomes.isEmpty()) {
+            publishRecords(true);
+            outcomes.wait(2000);
         }
         QQueue<TaskOutcome> batch;
-        while (!outcomes.isEmpty()) {
-            batch.enqueue(outcomes.dequeue());
+        batch.append(outcomes.drain());
+        for (const TaskOutcome &outcome : batch) {
+            const int sequence = jobOfFile.value(outcome.filePath, -1);
+            if (sequence < 0) {
+                continue;
+            }
+            jobOfFile.remove(outcome.filePath);
+            jobDurations[sequence] += outcome.elapsedMs;
+            int &remaining = jobRemaining[sequence];
+            remaining -= 1;
+            if (remaining == 0) {
+                jobRemaining.remove(sequence);
+                admission.release(sequence);
+                runningJobs -= 1;
+            }
+        }
+        discoveryMutex.lock();
+        while (!discovered.isEmpty()) {
+            found.append(discovered.dequeue());
+        }
+        walkDone = enumerated;
+        discoveryMutex.unlock();
+        for (const QVector<WalkedFile> &chunk : found) {
+            admit(chunk);
+        }
+        if (walkDone && !flushed) {
+            flushed = true;
+            for (const QString &suffix : batches.keys()) {
+                flushBatch(suffix, true);
+            }
+            if (!useFileList && walker.directoryCount() > 0) {
+                log(QString("目录扫描完成：%1 个目录，发现 %2 张图片").arg(walker.directoryCount()).arg(discoveredCount));
+            }
+            if (skippedCount > 0) {
+                log(QString("跳过 %1 张未变化的图片（与上次压缩记录一致）").arg(skippedCount));
+            }
+            if (discoveredCount == 0) {
+                log("未找到可压缩图片");
+                publishRecords(true);
+                emit finished(0, 0, 0, 0);
+                return;
+            }
+            if (total == 0) {
+                log("所有图片均未变化，无需重新压缩");
+                emit progressChanged(100);
+                publishRecords(true);
+                emit finished(0, 0, 0, 0);
+                return;
+            }
         }
-        queueMutex.unlock();
         if (batch.isEmpty()) {
             const QDateTime now = QDateTime::currentDateTime();
+            if (lastHeartbeat.msecsTo(now) >= 10000 && !walkDone) {
+                log(QString("正在扫描：已发现 %1 张图片，已完成 %2 张").arg(discoveredCount).arg(completed));
+                lastHeartbeat = now;
+            }
             if (lastHeartbeat.msecsTo(now) >= 10000 && !activeTasks.isEmpty()) {
                 QVector<QPair<qint64, QString>> longest;
                 longest.reserve(activeTasks.size());
@@ -444,7 +959,7 @@ void CompressWorker::run() {
                 for (int i = 0; i < limit; i += 1) {
                     items << QString("%1(%2s)").arg(longest[i].second).arg(longest[i].first / 1000.0, 0, 'f', 1);
                 }
-                emit logMessage(QString("处理中 %1 张，最长已运行：%2").arg(activeTasks.size()).arg(items.join("，")));
+                log(QString("处理中 %1 张，最长已运行：%2").arg(activeTasks.size()).arg(items.join("，")));
                 lastHeartbeat = now;
             }
         }
@@ -452,38 +967,72 @@ void CompressWorker::run() {
             const TaskOutcome outcome = batch.dequeue();
             if (!outcome.filePath.isEmpty()) {
                 activeTasks.remove(outcome.filePath);
+                pendingFiles.remove(outcome.filePath);
+                contentLeaders.remove(leaderKeys.take(outcome.filePath));
+            }
+            const QStringList copies = duplicates.take(outcome.filePath);
+            for (const QString &copy : copies) {
+                const QString copyOutput = copyOutputs.take(copy);
+                const SourceStamp copyStamp = duplicateStamps.take(copy);
+                if (outcome.hasResult && outcome.result.success && QFileInfo::exists(outcome.outputPath)) {
+                    batch.enqueue(mirrorOutcome(outcome, copy, copyOutput, copyStamp));
+                } else {
+                    pendingFiles.insert(copy);
+                    enqueueJob({pendingFile(copy, copyOutput, ImageProbe::probe(copy), copyStamp)});
+                }
+            }
+            for (const LogRecord &entry : outcome.logs) {
+                record(entry);
             }
-            for (const QString &line : outcome.logs) {
-                emit logMessage(line);
+            if (manifestReady && outcome.hasResult && outcome.result.success && outcome.source.valid) {
+                manifest.insert({
+                    pathKey(inputRoot, outcome.filePath),
+                    outcome.source.contentHash,
+                    outcome.source.size,
+                    outcome.source.mtimeMs,
+                    optionsHash,
+                    engineHash,
+                    outputIndexOf(outcome.filePath, outcome.outputPath)
+                });
             }
             if (outcome.hasResult) {
+                if (outcome.result.aborted) {
+                    abortedCount += 1;
+                    cpuSavedMs += outcome.result.cpuSavedMs;
+                }
                 if (outcome.result.success) {
                     successCount += 1;
                     totalBefore += outcome.result.originalSize;
                     totalAfter += outcome.result.outputSize;
-                    const double ratio = outcome.result.originalSize > 0
-                        ? 1.0 - (static_cast<double>(outcome.result.outputSize) / outcome.result.originalSize)
-                        : 0.0;
-                    emit logMessage(
-                        QString("%1 压缩完成，节省 %2，引擎 %3，耗时 %4s")
-                            .arg(outcome.fileName)
-                            .arg(QString::number(ratio * 100.0, 'f', 1) + "%")
-                            .arg(outcome.result.engine)
-                            .arg(outcome.elapsedMs / 1000.0, 0, 'f', 1)
-                    );
+                    record(LogRecord::compressed(
+                        outcome.fileName,
+                        outcome.result.engine,
+                        outcome.result.originalSize,
+                        outcome.result.outputSize,
+                        outcome.elapsedMs
+                    ));
                 } else {
-                    emit logMessage(
-                        QString("%1 压缩失败：%2，耗时 %3s")
-                            .arg(outcome.fileName)
-                            .arg(outcome.result.message)
-                            .arg(outcome.elapsedMs / 1000.0, 0, 'f', 1)
-                    );
+                    record(LogRecord::failed(outcome.fileName, outcome.result.message, outcome.elapsedMs));
                 }
             }
             completed += 1;
-            const int percent = static_cast<int>((static_cast<double>(completed) / total) * 100.0);
-            emit progressChanged(percent);
+            int percent = static_cast<int>((static_cast<double>(completed) / total) * 100.0);
+            if (!flushed) {
+                percent = qMin(percent, 99);
+            }
+            if (percent > lastPercent) {
+                lastPercent = percent;
+                emit progressChanged(percent);
+            }
+        }
+        refill();
+        if (flushed) {
+            budget.setRemaining(runningJobs + static_cast<int>(ready[0].size() + ready[1].size()));
         }
+        if (flushed && tailStarted.isNull() && ready[0].isEmpty() && ready[1].isEmpty() && runningJobs < concurrency) {
+            tailStarted = QDateTime::currentDateTime();
+        }
+        publishRecords(false);
     }
     pool.waitForDone();
     emit progressChanged(100);
@@ -491,12 +1040,53 @@ void CompressWorker::run() {
     const double totalRatio = totalBefore > 0
         ? static_cast<double>(saved) / totalBefore
         : 0.0;
-    const qint64 elapsedMs = started.msecsTo(QDateTime::currentDateTime());
-    emit logMessage(
+    const QDateTime finishedAt = QDateTime::currentDateTime();
+    const qint64 elapsedMs = started.msecsTo(finishedAt);
+    log(
         QString("完成：成功 %1 张，节省 %2，用时 %3 秒")
             .arg(successCount)
             .arg(QString::number(totalRatio * 100.0, 'f', 1) + "%")
             .arg(QString::number(elapsedMs / 1000.0, 'f', 1))
     );
+    if (!tailStarted.isNull() && jobDurations.size() > concurrency) {
+        log(
+            QString("大图优先调度：尾段（出现空闲线程到全部完成）%1 秒，按发现顺序调度估算为 %2 秒")
+                .arg(QString::number(tailStarted.msecsTo(finishedAt) / 1000.0, 'f', 1))
+                .arg(QString::number(listScheduleTail(jobDurations, concurrency) / 1000.0, 'f', 1))
+        );
+    }
+    if (budget.boostedCount() > 0) {
+        log(
+            QString("尾段加速：剩余任务少于线程数后，%1 次引擎调用分到了空闲的 CPU 令牌（共 %2 个）")
+                .arg(budget.boostedCount())
+                .arg(budget.tokens())
+        );
+    }
+    if (deferredJobs > 0) {
+        log(
+            QString("内存准入：%1 个任务因预算不足延后启动，估算峰值占用 %2 MB / 预算 %3 MB")
+                .arg(deferredJobs)
+                .arg(admission.peak() / kMegabyte)
+                .arg(admission.budget() / kMegabyte)
+        );
+    }
+    if (duplicateCount > 0) {
+        log(QString("发现 %1 张内容重复的图片，已复用同内容文件的压缩结果").arg(duplicateCount));
+    }
+    if (abortedCount > 0) {
+        log(
+            QString("提前终止 %1 次超出原图体积的编码，约节省 CPU %2 秒")
+                .arg(abortedCount)
+                .arg(QString::number(cpuSavedMs / 1000.0, 'f', 1))
+        );
+    }
+    if (OutputCache::isEnabled()) {
+        log(
+            QString("输出缓存命中 %1 次，未命中 %2 次")
+                .arg(OutputCache::hits())
+                .arg(OutputCache::misses())
+        );
+    }
+    publishRecords(true);
     emit finished(successCount, totalBefore, totalAfter, elapsedMs);
 }
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QString>
 #include <QStringList>
+#include <QThreadPool>
+#include <QVector>
 
+#include "core/DirectoryWalker.h"
+#include "core/LogRecord.h"
 #include "engine/EngineRegistry.h"
 
 class CompressWorker final : public QObject {
@@ -16,7 +21,8 @@ public:
         const QString &inputDir,
         const QString &outputDir,
         const QStringList &formats,
-        const CompressionOptions &options
+        const CompressionOptions &options,
+        const QVector<WalkedFile> &scannedFiles
     );
     void configureFiles(
         const QStringList &files,
@@ -28,17 +34,27 @@ public:
 
 public slots:
     void run();
+    void runFiles(const QStringList &files);
 
 signals:
     void progressChanged(int percent);
-    void logMessage(const QString &message);
+    void logRecords(const QVector<LogRecord> &records);
     void finished(int successCount, qint64 totalBefore, qint64 totalAfter, qint64 elapsedMs);
 
 private:
+    void log(const QString &message);
+    void record(const LogRecord &entry);
+    void publishRecords(bool force);
+
     QString inputDir;
     QString outputDir;
     QStringList formats;
     CompressionOptions options;
     QStringList files;
+    QVector<WalkedFile> scannedFiles;
     bool useFileList;
+    bool watchDispatch;
+    QVector<LogRecord> records;
+    QElapsedTimer recordTimer;
+    QThreadPool pool;
 };
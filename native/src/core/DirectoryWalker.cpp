@@ -0,0 +1,258 @@
+#include "DirectoryWalker.h"
+
+#include <QDir>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const int kFlushFiles = 512;
+
+#if defined(Q_OS_LINUX)
+const int kDirentBufferSize = 64 * 1024;
+
+struct EntryStat {
+    unsigned int mode;
+    qint64 size;
+    qint64 mtimeMs;
+};
+
+bool statEntry(int dirFd, const char *name, bool follow, EntryStat *stat) {
+#if defined(STATX_SIZE)
+    struct statx info;
+    const int flags = AT_NO_AUTOMOUNT | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+    if (statx(dirFd, name, flags, STATX_TYPE | STATX_SIZE | STATX_MTIME, &info) != 0) {
+        return false;
+    }
+    stat->mode = info.stx_mode;
+    stat->size = static_cast<qint64>(info.stx_size);
+    stat->mtimeMs = static_cast<qint64>(info.stx_mtime.tv_sec) * 1000 + info.stx_mtime.tv_nsec / 1000000;
+    return true;
+#else
+    struct stat info;
+    if (fstatat(dirFd, name, &info, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    stat->mode = info.st_mode;
+    stat->size = static_cast<qint64>(info.st_size);
+    stat->mtimeMs = static_cast<qint64>(info.st_mtim.tv_sec) * 1000 + info.st_mtim.tv_nsec / 1000000;
+    return true;
+#endif
+}
+#endif
+}
+
+DirectoryWalker::DirectoryWalker(const QStringList &suffixes, FilesFound onFiles, Finished onFinished)
+    : recordDirectories(false),
+      filesFound(std::move(onFiles)),
+      finishedCallback(std::move(onFinished)),
+      pending(0),
+      directories(0),
+      files(0),
+      cancelled(false) {
+    for (const QString &suffix : suffixes) {
+        suffixSet.insert(suffix.toLower());
+    }
+    pool.setMaxThreadCount(qBound(4, QThread::idealThreadCount() * 2, 32));
+}
+
+DirectoryWalker::~DirectoryWalker() {
+    cancel();
+    waitForDone();
+}
+
+void DirectoryWalker::setExcluded(const QString &path) {
+    excluded = path.isEmpty() ? QString() : QDir::cleanPath(QDir(path).absolutePath());
+}
+
+void DirectoryWalker::setRecordDirectories(bool record) {
+    recordDirectories = record;
+}
+
+void DirectoryWalker::start(const QStringList &roots) {
+    pending += 1;
+    for (const QString &root : roots) {
+        schedule(QDir::cleanPath(QDir(root).absolutePath()));
+    }
+    release();
+}
+
+void DirectoryWalker::cancel() {
+    cancelled = true;
+}
+
+void DirectoryWalker::waitForDone() {
+    pool.waitForDone();
+}
+
+int DirectoryWalker::directoryCount() const {
+    return directories;
+}
+
+int DirectoryWalker::fileCount() const {
+    return files;
+}
+
+QVector<WalkedDirectory> DirectoryWalker::walkedDirectories() const {
+    QMutexLocker locker(&directoryMutex);
+    return directoryStamps;
+}
+
+void DirectoryWalker::recordDirectory(const QString &path, qint64 mtimeMs) {
+    if (!recordDirectories) {
+        return;
+    }
+    QMutexLocker locker(&directoryMutex);
+    directoryStamps.append({path, mtimeMs});
+}
+
+void DirectoryWalker::schedule(const QString &path) {
+    if (!excluded.isEmpty() && path == excluded) {
+        return;
+    }
+    pending += 1;
+    pool.start([this, path]() {
+        if (!cancelled) {
+            scan(path);
+        }
+        release();
+    });
+}
+
+void DirectoryWalker::release() {
+    if (pending.fetch_sub(1) == 1 && finishedCallback) {
+        finishedCallback();
+    }
+}
+
+bool DirectoryWalker::accepts(const QString &name) const {
+    const int dot = name.lastIndexOf('.');
+    return dot > 0 && suffixSet.contains(name.mid(dot + 1).toLower());
+}
+
+void DirectoryWalker::deliver(QVector<WalkedFile> *found) {
+    if (found->isEmpty()) {
+        return;
+    }
+    files += found->size();
+    if (filesFound) {
+        filesFound(*found);
+    }
+    found->clear();
+}
+
+void DirectoryWalker::inspect(const QString &path) {
+    if (!accepts(path.mid(path.lastIndexOf('/') + 1))) {
+        return;
+    }
+    const QFileInfo info(path);
+    if (!info.isFile()) {
+        return;
+    }
+    QVector<WalkedFile> found{{path, info.size(), info.lastModified().toMSecsSinceEpoch()}};
+    deliver(&found);
+}
+
+void DirectoryWalker::scan(const QString &path) {
+    QVector<WalkedFile> found;
+#if defined(Q_OS_LINUX)
+    const int dirFd = open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0) {
+        if (errno == ENOTDIR) {
+            inspect(path);
+        }
+        return;
+    }
+    directories += 1;
+    if (recordDirectories) {
+        EntryStat stat{0, 0, 0};
+        recordDirectory(path, statEntry(dirFd, ".", true, &stat) ? stat.mtimeMs : -1);
+    }
+    QByteArray buffer(kDirentBufferSize, Qt::Uninitialized);
+    while (!cancelled) {
+        const long count = syscall(SYS_getdents64, dirFd, buffer.data(), buffer.size());
+        if (count <= 0) {
+            break;
+        }
+        long offset = 0;
+        while (offset < count) {
+            const auto *entry = reinterpret_cast<const struct dirent64 *>(buffer.constData() + offset);
+            offset += entry->d_reclen;
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            unsigned char type = entry->d_type;
+            EntryStat stat{0, 0, 0};
+            bool statted = false;
+            if (type == DT_UNKNOWN) {
+                if (!statEntry(dirFd, entry->d_name, false, &stat)) {
+                    continue;
+                }
+                type = S_ISDIR(stat.mode) ? DT_DIR : (S_ISREG(stat.mode) ? DT_REG : (S_ISLNK(stat.mode) ? DT_LNK : DT_UNKNOWN));
+                statted = type == DT_REG;
+            }
+            const QString name = QFile::decodeName(entry->d_name);
+            if (type == DT_DIR) {
+                schedule(path + "/" + name);
+                continue;
+            }
+            if ((type != DT_REG && type != DT_LNK) || !accepts(name)) {
+                continue;
+            }
+            if (!statted && !statEntry(dirFd, entry->d_name, true, &stat)) {
+                continue;
+            }
+            if (!S_ISREG(stat.mode)) {
+                continue;
+            }
+            found.append({path + "/" + name, stat.size, stat.mtimeMs});
+            if (found.size() >= kFlushFiles) {
+                deliver(&found);
+            }
+        }
+    }
+    close(dirFd);
+#else
+    if (!QFileInfo(path).isDir()) {
+        inspect(path);
+        return;
+    }
+    directories += 1;
+    if (recordDirectories) {
+        recordDirectory(path, QFileInfo(path).lastModified().toMSecsSinceEpoch());
+    }
+    const QFileInfoList entries = QDir(path).entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot);
+    for (const QFileInfo &entry : entries) {
+        if (cancelled) {
+            break;
+        }
+        if (entry.isDir()) {
+            if (!entry.isSymLink()) {
+                schedule(entry.absoluteFilePath());
+            }
+            continue;
+        }
+        if (!entry.isFile() || !accepts(entry.fileName())) {
+            continue;
+        }
+        found.append({entry.absoluteFilePath(), entry.size(), entry.lastModified().toMSecsSinceEpoch()});
+        if (found.size() >= kFlushFiles) {
+            deliver(&found);
+        }
+    }
+#endif
+    if (!cancelled) {
+        deliver(&found);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+struct WalkedFile {
+    QString path;
+    qint64 size;
+    qint64 mtimeMs;
+};
+
+struct WalkedDirectory {
+    QString path;
+    qint64 mtimeMs;
+};
+
+class DirectoryWalker {
+public:
+    using FilesFound = std::function<void(const QVector<WalkedFile> &files)>;
+    using Finished = std::function<void()>;
+
+    DirectoryWalker(const QStringList &suffixes, FilesFound onFiles, Finished onFinished);
+    ~DirectoryWalker();
+
+    void setExcluded(const QString &path);
+    void setRecordDirectories(bool record);
+    void start(const QStringList &roots);
+    void cancel();
+    void waitForDone();
+    int directoryCount() const;
+    int fileCount() const;
+    QVector<WalkedDirectory> walkedDirectories() const;
+
+private:
+    void schedule(const QString &path);
+    void release();
+    void scan(const QString &path);
+    void inspect(const QString &path);
+    bool accepts(const QString &name) const;
+    void deliver(QVector<WalkedFile> *found);
+    void recordDirectory(const QString &path, qint64 mtimeMs);
+
+    QSet<QString> suffixSet;
+    QString excluded;
+    bool recordDirectories;
+    mutable QMutex directoryMutex;
+    QVector<WalkedDirectory> directoryStamps;
+    FilesFound filesFound;
+    Finished finishedCallback;
+    QThreadPool pool;
+    std::atomic<int> pending;
+    std::atomic<int> directories;
+    std::atomic<int> files;
+    std::atomic<bool> cancelled;
+};
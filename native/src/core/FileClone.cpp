@@ -0,0 +1,84 @@
+#include "FileClone.h"
+
+#include <QFile>
+#include <QtGlobal>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#elif defined(Q_OS_MACOS)
+#include <sys/clonefile.h>
+#include <unistd.h>
+#elif !defined(Q_OS_WIN)
+#include <unistd.h>
+#endif
+
+namespace {
+bool reflink(const QByteArray &source, const QByteArray &target) {
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+    const int input = open(source.constData(), O_RDONLY | O_CLOEXEC);
+    if (input < 0) {
+        return false;
+    }
+    const int output = open(target.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (output < 0) {
+        close(input);
+        return false;
+    }
+    const bool cloned = ioctl(output, FICLONE, input) == 0;
+    close(output);
+    close(input);
+    if (!cloned) {
+        unlink(target.constData());
+    }
+    return cloned;
+#elif defined(Q_OS_MACOS)
+    return clonefile(source.constData(), target.constData(), 0) == 0;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(target);
+    return false;
+#endif
+}
+
+bool hardlink(const QByteArray &source, const QByteArray &target) {
+#if defined(Q_OS_WIN)
+    Q_UNUSED(source);
+    Q_UNUSED(target);
+    return false;
+#else
+    return link(source.constData(), target.constData()) == 0;
+#endif
+}
+}
+
+FileClone::Method FileClone::materialize(const QString &source, const QString &target) {
+    const QByteArray sourcePath = QFile::encodeName(source);
+    const QByteArray targetPath = QFile::encodeName(target);
+    if (reflink(sourcePath, targetPath)) {
+        return Method::Reflink;
+    }
+    if (hardlink(sourcePath, targetPath)) {
+        return Method::Hardlink;
+    }
+    if (QFile::copy(source, target)) {
+        return Method::Copy;
+    }
+    return Method::Failed;
+}
+
+QString FileClone::methodName(Method method) {
+    switch (method) {
+    case Method::Reflink:
+        return "reflink";
+    case Method::Hardlink:
+        return "硬链接";
+    case Method::Copy:
+        return "复制";
+    case Method::Failed:
+        break;
+    }
+    return "失败";
+}
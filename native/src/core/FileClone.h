@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QString>
+
+class FileClone {
+public:
+    enum class Method {
+        Reflink,
+        Hardlink,
+        Copy,
+        Failed
+    };
+
+    static Method materialize(const QString &source, const QString &target);
+    static QString methodName(Method method);
+};
@@ -0,0 +1,173 @@
+#include "FileScanner.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMetaObject>
+
+namespace {
+const qint64 kReuseMs = 60 * 1000;
+const qint64 kMtimeSlackMs = 2000;
+const int kFreshCheckDirectories = 4096;
+const qint64 kProgressMs = 100;
+const QStringList kSupportedSuffixes = {"jpg", "jpeg", "png", "gif", "webp"};
+const QStringList kUnsupportedSuffixes = {"bmp", "tif", "tiff", "heic", "heif", "avif", "svg"};
+
+QString suffixOf(const QString &path) {
+    const int dot = path.lastIndexOf('.');
+    if (dot <= path.lastIndexOf('/') + 1) {
+        return QString();
+    }
+    return path.mid(dot + 1).toLower();
+}
+}
+
+FileScanner::FileScanner(QObject *parent) : QObject(parent), generation(0), scanning(false), startedMs(0) {}
+
+FileScanner::~FileScanner() {
+    for (DirectoryWalker *walker : walkers) {
+        walker->cancel();
+    }
+    qDeleteAll(walkers);
+}
+
+void FileScanner::scan(const QStringList &pathsValue) {
+    cancel();
+    generation += 1;
+    const quint64 id = generation;
+    scanPaths = pathsValue;
+    supported.clear();
+    unsupported.clear();
+    seen.clear();
+    found.clear();
+    directories.clear();
+    startedMs = QDateTime::currentMSecsSinceEpoch();
+    completedAt.invalidate();
+    lastProgress.invalidate();
+    scanning = true;
+    auto *walker = new DirectoryWalker(
+        kSupportedSuffixes + kUnsupportedSuffixes,
+        [this, id](const QVector<WalkedFile> &batch) {
+            QMetaObject::invokeMethod(this, [this, id, batch]() {
+                absorb(id, batch);
+            }, Qt::QueuedConnection);
+        },
+        [this, id]() {
+            QMetaObject::invokeMethod(this, [this, id]() {
+                complete(id);
+            }, Qt::QueuedConnection);
+        }
+    );
+    walker->setRecordDirectories(true);
+    walkers.insert(id, walker);
+    walker->start(pathsValue);
+}
+
+void FileScanner::cancel() {
+    if (!scanning) {
+        return;
+    }
+    DirectoryWalker *walker = walkers.value(generation);
+    if (walker) {
+        walker->cancel();
+    }
+    scanning = false;
+    scanPaths.clear();
+    supported.clear();
+    unsupported.clear();
+    seen.clear();
+    found.clear();
+    directories.clear();
+}
+
+bool FileScanner::isScanning() const {
+    return scanning;
+}
+
+bool FileScanner::isFresh(const QStringList &pathsValue) const {
+    if (scanning
+        || !completedAt.isValid()
+        || completedAt.elapsed() > kReuseMs
+        || scanPaths != pathsValue
+        || directories.isEmpty()
+        || directories.size() > kFreshCheckDirectories) {
+        return false;
+    }
+    for (const WalkedDirectory &directory : directories) {
+        if (directory.mtimeMs < 0 || directory.mtimeMs > startedMs - kMtimeSlackMs) {
+            return false;
+        }
+        const QFileInfo info(directory.path);
+        if (!info.isDir() || info.lastModified().toMSecsSinceEpoch() != directory.mtimeMs) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QStringList FileScanner::paths() const {
+    return scanPaths;
+}
+
+QVector<WalkedFile> FileScanner::files() const {
+    return supported;
+}
+
+QStringList FileScanner::filePaths() const {
+    QStringList result;
+    result.reserve(supported.size());
+    for (const WalkedFile &file : supported) {
+        result.append(file.path);
+    }
+    return result;
+}
+
+QStringList FileScanner::unsupportedFiles() const {
+    return unsupported;
+}
+
+QSet<QString> FileScanner::formats() const {
+    return found;
+}
+
+void FileScanner::absorb(quint64 id, const QVector<WalkedFile> &batch) {
+    if (id != generation || !scanning) {
+        return;
+    }
+    const int knownFormats = found.size();
+    for (const WalkedFile &file : batch) {
+        if (seen.contains(file.path)) {
+            continue;
+        }
+        seen.insert(file.path);
+        const QString suffix = suffixOf(file.path);
+        if (!kSupportedSuffixes.contains(suffix)) {
+            unsupported.append(file.path);
+            continue;
+        }
+        supported.append(file);
+        found.insert(suffix == "jpeg" ? "jpg" : suffix);
+    }
+    if (found.size() != knownFormats) {
+        emit formatsChanged(found);
+    }
+    if (!lastProgress.isValid() || lastProgress.elapsed() >= kProgressMs) {
+        lastProgress.start();
+        emit progress(supported.size());
+    }
+}
+
+void FileScanner::complete(quint64 id) {
+    DirectoryWalker *walker = walkers.take(id);
+    const bool current = id == generation && scanning;
+    if (current && walker) {
+        directories = walker->walkedDirectories();
+    }
+    delete walker;
+    if (!current) {
+        return;
+    }
+    scanning = false;
+    completedAt.start();
+    emit progress(supported.size());
+    emit finished();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "core/DirectoryWalker.h"
+
+class FileScanner final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FileScanner(QObject *parent = nullptr);
+    ~FileScanner() override;
+
+    void scan(const QStringList &paths);
+    void cancel();
+    bool isScanning() const;
+    bool isFresh(const QStringList &paths) const;
+    QStringList paths() const;
+    QVector<WalkedFile> files() const;
+    QStringList filePaths() const;
+    QStringList unsupportedFiles() const;
+    QSet<QString> formats() const;
+
+signals:
+    void formatsChanged(const QSet<QString> &formats);
+    void progress(int files);
+    void finished();
+
+private:
+    void absorb(quint64 generation, const QVector<WalkedFile> &found);
+    void complete(quint64 generation);
+    bool classify(const WalkedFile &file);
+
+    quint64 generation;
+    bool scanning;
+    QStringList scanPaths;
+    QHash<quint64, DirectoryWalker *> walkers;
+    QVector<WalkedFile> supported;
+    QStringList unsupported;
+    QSet<QString> seen;
+    QSet<QString> found;
+    QVector<WalkedDirectory> directories;
+    qint64 startedMs;
+    QElapsedTimer completedAt;
+    QElapsedTimer lastProgress;
+};
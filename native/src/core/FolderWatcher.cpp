@@ -0,0 +1,168 @@
+#include "FolderWatcher.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+
+namespace {
+const int kSettleMs = 1000;
+
+WatchedFile stampOf(const QFileInfo &info) {
+    return {info.size(), info.lastModified().toMSecsSinceEpoch()};
+}
+
+bool sameStamp(const WatchedFile &a, const WatchedFile &b) {
+    return a.size == b.size && a.mtimeMs == b.mtimeMs;
+}
+}
+
+FolderWatcher::FolderWatcher(QObject *parent) : QObject(parent) {
+    settleTimer.setSingleShot(true);
+    settleTimer.setInterval(kSettleMs);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &FolderWatcher::onDirectoryChanged);
+    connect(&settleTimer, &QTimer::timeout, this, &FolderWatcher::settle);
+}
+
+bool FolderWatcher::start(const QString &rootDir, const QString &excludedDir, const QStringList &formats) {
+    stop();
+    root = QDir(rootDir).absolutePath();
+    excluded = excludedDir.isEmpty() ? QString() : QDir(excludedDir).absolutePath();
+    for (const QString &fmt : formats) {
+        suffixes.insert(fmt.toLower());
+    }
+    watchTree(root, true);
+    if (watchedDirs.isEmpty()) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void FolderWatcher::stop() {
+    settleTimer.stop();
+    const QStringList dirs = watcher.directories();
+    if (!dirs.isEmpty()) {
+        watcher.removePaths(dirs);
+    }
+    root.clear();
+    excluded.clear();
+    suffixes.clear();
+    watchedDirs.clear();
+    dirtyDirs.clear();
+    pending.clear();
+    delivered.clear();
+}
+
+bool FolderWatcher::isActive() const {
+    return !root.isEmpty();
+}
+
+void FolderWatcher::onDirectoryChanged(const QString &path) {
+    dirtyDirs.insert(path);
+    if (!settleTimer.isActive()) {
+        settleTimer.start();
+    }
+}
+
+void FolderWatcher::settle() {
+    QStringList ready;
+    for (auto it = pending.begin(); it != pending.end();) {
+        const QFileInfo info(it.key());
+        if (!info.isFile()) {
+            it = pending.erase(it);
+            continue;
+        }
+        const WatchedFile current = stampOf(info);
+        if (sameStamp(current, it.value())) {
+            ready.append(it.key());
+            delivered.insert(it.key(), current);
+            it = pending.erase(it);
+        } else {
+            it.value() = current;
+            ++it;
+        }
+    }
+    const QSet<QString> dirs = dirtyDirs;
+    dirtyDirs.clear();
+    for (const QString &dir : dirs) {
+        if (!QFileInfo(dir).isDir()) {
+            for (auto it = watchedDirs.begin(); it != watchedDirs.end();) {
+                if (*it == dir || it->startsWith(dir + "/")) {
+                    it = watchedDirs.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            continue;
+        }
+        QDirIterator it(dir, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+        while (it.hasNext()) {
+            const QString path = it.next();
+            if (it.fileInfo().isDir()) {
+                if (!watchedDirs.contains(path)) {
+                    watchTree(path, false);
+                }
+            } else {
+                observe(path);
+            }
+        }
+    }
+    if (!pending.isEmpty() || !dirtyDirs.isEmpty()) {
+        settleTimer.start();
+    }
+    if (!ready.isEmpty()) {
+        emit filesReady(ready);
+    }
+}
+
+void FolderWatcher::watchTree(const QString &dir, bool recordExisting) {
+    if (isExcluded(dir)) {
+        return;
+    }
+    QStringList dirs{dir};
+    QDirIterator it(dir, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (!isExcluded(path) && !watchedDirs.contains(path)) {
+            dirs.append(path);
+        }
+    }
+    watcher.addPaths(dirs);
+    for (const QString &path : dirs) {
+        watchedDirs.insert(path);
+        QDirIterator files(path, QDir::Files);
+        while (files.hasNext()) {
+            const QString file = files.next();
+            if (!isImage(file)) {
+                continue;
+            }
+            if (recordExisting) {
+                delivered.insert(file, stampOf(files.fileInfo()));
+            } else {
+                observe(file);
+            }
+        }
+    }
+}
+
+void FolderWatcher::observe(const QString &file) {
+    if (!isImage(file) || pending.contains(file)) {
+        return;
+    }
+    const QFileInfo info(file);
+    const WatchedFile current = stampOf(info);
+    const auto known = delivered.constFind(file);
+    if (known != delivered.constEnd() && sameStamp(known.value(), current)) {
+        return;
+    }
+    pending.insert(file, current);
+}
+
+bool FolderWatcher::isImage(const QString &file) const {
+    return suffixes.contains(QFileInfo(file).suffix().toLower());
+}
+
+bool FolderWatcher::isExcluded(const QString &path) const {
+    return !excluded.isEmpty() && (path == excluded || path.startsWith(excluded + "/"));
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+struct WatchedFile {
+    qint64 size;
+    qint64 mtimeMs;
+};
+
+class FolderWatcher final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FolderWatcher(QObject *parent = nullptr);
+
+    bool start(const QString &rootDir, const QString &excludedDir, const QStringList &formats);
+    void stop();
+    bool isActive() const;
+
+signals:
+    void filesReady(const QStringList &files);
+
+private:
+    void onDirectoryChanged(const QString &path);
+    void settle();
+    void watchTree(const QString &dir, bool recordExisting);
+    void observe(const QString &file);
+    bool isImage(const QString &file) const;
+    bool isExcluded(const QString &path) const;
+
+    QFileSystemWatcher watcher;
+    QTimer settleTimer;
+    QString root;
+    QString excluded;
+    QSet<QString> suffixes;
+    QSet<QString> watchedDirs;
+    QSet<QString> dirtyDirs;
+    QHash<QString, WatchedFile> pending;
+    QHash<QString, WatchedFile> delivered;
+};
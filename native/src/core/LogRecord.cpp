@@ -0,0 +1,37 @@
+#include "LogRecord.h"
+
+LogRecord LogRecord::message(const QString &text) {
+    return {LogKind::Message, QString(), text, 0, 0, 0};
+}
+
+LogRecord LogRecord::warning(const QString &text) {
+    return {LogKind::Warning, QString(), text, 0, 0, 0};
+}
+
+LogRecord LogRecord::compressed(const QString &file, const QString &engine, qint64 originalSize, qint64 outputSize, qint64 elapsedMs) {
+    return {LogKind::Compressed, file, engine, originalSize, outputSize, elapsedMs};
+}
+
+LogRecord LogRecord::failed(const QString &file, const QString &reason, qint64 elapsedMs) {
+    return {LogKind::Failed, file, reason, 0, 0, elapsedMs};
+}
+
+QString LogRecord::text() const {
+    if (kind == LogKind::Compressed) {
+        const double ratio = originalSize > 0
+            ? 1.0 - (static_cast<double>(outputSize) / originalSize)
+            : 0.0;
+        return QString("%1 压缩完成，节省 %2，引擎 %3，耗时 %4s")
+            .arg(file)
+            .arg(QString::number(ratio * 100.0, 'f', 1) + "%")
+            .arg(detail)
+            .arg(elapsedMs / 1000.0, 0, 'f', 1);
+    }
+    if (kind == LogKind::Failed) {
+        return QString("%1 压缩失败：%2，耗时 %3s")
+            .arg(file)
+            .arg(detail)
+            .arg(elapsedMs / 1000.0, 0, 'f', 1);
+    }
+    return detail;
+}
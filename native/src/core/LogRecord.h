@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+enum class LogKind {
+    Message,
+    Warning,
+    Compressed,
+    Failed,
+};
+
+struct LogRecord {
+    LogKind kind;
+    QString file;
+    QString detail;
+    qint64 originalSize;
+    qint64 outputSize;
+    qint64 elapsedMs;
+
+    static LogRecord message(const QString &text);
+    static LogRecord warning(const QString &text);
+    static LogRecord compressed(const QString &file, const QString &engine, qint64 originalSize, qint64 outputSize, qint64 elapsedMs);
+    static LogRecord failed(const QString &file, const QString &reason, qint64 elapsedMs);
+
+    QString text() const;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QSemaphore>
+#include <QVector>
+#include <atomic>
+#include <utility>
+
+template <typename T>
+class MpscChannel {
+public:
+    MpscChannel() : head(nullptr) {}
+
+    ~MpscChannel() {
+        drain();
+    }
+
+    MpscChannel(const MpscChannel &) = delete;
+    MpscChannel &operator=(const MpscChannel &) = delete;
+
+    void push(T value) {
+        Node *node = new Node{std::move(value), nullptr};
+        Node *expected = head.load(std::memory_order_relaxed);
+        do {
+            node->next = expected;
+        } while (!head.compare_exchange_weak(expected, node, std::memory_order_release, std::memory_order_relaxed));
+        if (!expected) {
+            signal.release();
+        }
+    }
+
+    QVector<T> drain() {
+        Node *node = head.exchange(nullptr, std::memory_order_acquire);
+        Node *ordered = nullptr;
+        int count = 0;
+        while (node) {
+            Node *next = node->next;
+            node->next = ordered;
+            ordered = node;
+            node = next;
+            count += 1;
+        }
+        QVector<T> items;
+        items.reserve(count);
+        while (ordered) {
+            Node *next = ordered->next;
+            items.append(std::move(ordered->value));
+            delete ordered;
+            ordered = next;
+        }
+        return items;
+    }
+
+    bool isEmpty() const {
+        return head.load(std::memory_order_acquire) == nullptr;
+    }
+
+    void wait(int timeoutMs) {
+        signal.tryAcquire(1, timeoutMs);
+        signal.tryAcquire(signal.available());
+    }
+
+    void notify() {
+        signal.release();
+    }
+
+private:
+    struct Node {
+        T value;
+        Node *next;
+    };
+
+    std::atomic<Node *> head;
+    QSemaphore signal;
+};
@@ -0,0 +1,106 @@
+#include "OutputPlanner.h"
+
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+
+namespace {
+QString nameKey(const QString &name) {
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+    return name.toLower();
+#else
+    return name;
+#endif
+}
+
+void indexDirectory(const QString &path, OutputDirectory *index) {
+    QDir dir(path);
+    index->ready = dir.mkpath(".");
+    if (!index->ready) {
+        return;
+    }
+    const QStringList entries = dir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+    index->taken.reserve(entries.size());
+    for (const QString &entry : entries) {
+        index->taken.insert(nameKey(entry));
+    }
+}
+}
+
+QString OutputPlan::outputFor(const QString &file) const {
+    return paths.value(QFileInfo(file).absoluteFilePath());
+}
+
+OutputPlanner::OutputPlanner(const QDir &inputRoot, const QDir &outputRoot)
+    : input(inputRoot),
+      rootPath(QDir::cleanPath(outputRoot.absolutePath())) {}
+
+OutputPlan OutputPlanner::plan(const QStringList &files, const QStringList &targetFormats) {
+    OutputPlan result{QHash<QString, QString>(), 0, 0};
+    const int known = directories.size();
+    QVector<int> owners;
+    owners.reserve(files.size());
+    for (const QString &file : files) {
+        const QString relativeDir = QFileInfo(input.relativeFilePath(file)).path();
+        const QString directory = relativeDir == "."
+            ? rootPath
+            : QDir::cleanPath(rootPath + "/" + relativeDir);
+        auto found = directoryIds.constFind(directory);
+        if (found == directoryIds.constEnd()) {
+            found = directoryIds.insert(directory, directories.size());
+            directories.append(directory);
+        }
+        owners.append(found.value());
+    }
+
+    indexes.resize(directories.size());
+    OutputDirectory *target = indexes.data();
+    QThreadPool dirPool;
+    dirPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    const int created = directories.size() - known;
+    const int chunk = qMax(1, created / (dirPool.maxThreadCount() * 4));
+    for (int begin = known; begin < directories.size(); begin += chunk) {
+        const int end = qMin(static_cast<int>(directories.size()), begin + chunk);
+        dirPool.start([this, target, begin, end]() {
+            for (int i = begin; i < end; i += 1) {
+                indexDirectory(directories.at(i), &target[i]);
+            }
+        });
+    }
+    dirPool.waitForDone();
+
+    for (int i = known; i < directories.size(); i += 1) {
+        if (indexes[i].ready) {
+            result.directories += 1;
+        } else {
+            result.failedDirectories += 1;
+        }
+        const QFileInfo dirInfo(directories[i]);
+        const auto parent = directoryIds.constFind(dirInfo.path());
+        if (parent != directoryIds.constEnd()) {
+            indexes[parent.value()].taken.insert(nameKey(dirInfo.fileName()));
+        }
+    }
+
+    result.paths.reserve(files.size());
+    for (int i = 0; i < files.size(); i += 1) {
+        OutputDirectory &index = indexes[owners[i]];
+        const QFileInfo sourceInfo(files[i]);
+        const QString stem = sourceInfo.completeBaseName();
+        const QString format = targetFormats.value(i);
+        const QString ext = format.isEmpty() ? QString() : "." + format;
+        QString name = stem + ext;
+        if (index.taken.contains(nameKey(name))) {
+            const QString counterKey = QString("%1/%2").arg(owners[i]).arg(nameKey(name));
+            int next = nextIndex.value(counterKey, 1);
+            do {
+                name = QString("%1(%2)%3").arg(stem).arg(next).arg(ext);
+                next += 1;
+            } while (index.taken.contains(nameKey(name)));
+            nextIndex.insert(counterKey, next);
+        }
+        index.taken.insert(nameKey(name));
+        result.paths.insert(sourceInfo.absoluteFilePath(), directories[owners[i]] + "/" + name);
+    }
+    return result;
+}
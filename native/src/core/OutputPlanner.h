@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QDir>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct OutputPlan {
+    QHash<QString, QString> paths;
+    int directories;
+    int failedDirectories;
+
+    QString outputFor(const QString &file) const;
+};
+
+struct OutputDirectory {
+    QSet<QString> taken;
+    bool ready;
+};
+
+class OutputPlanner {
+public:
+    OutputPlanner(const QDir &inputRoot, const QDir &outputRoot);
+
+    OutputPlan plan(const QStringList &files, const QStringList &targetFormats);
+
+private:
+    QDir input;
+    QString rootPath;
+    QStringList directories;
+    QHash<QString, int> directoryIds;
+    QVector<OutputDirectory> indexes;
+    QHash<QString, int> nextIndex;
+};
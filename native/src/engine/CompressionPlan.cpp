@@ -0,0 +1,191 @@
+#include "CompressionPlan.h"
+
+#include "PngOptimizer.h"
+#include "PngQuantizer.h"
+#include "ToolCatalog.h"
+#include "WebpCodec.h"
+
+namespace {
+const QStringList kFormats = {"jpg", "png", "gif", "webp"};
+
+ProfileLevel parseProfile(const QString &profile) {
+    if (profile.contains("强") || profile == "strong") {
+        return ProfileLevel::Strong;
+    }
+    if (profile.contains("均衡") || profile == "balanced") {
+        return ProfileLevel::Balanced;
+    }
+    return ProfileLevel::High;
+}
+
+int adjustQuality(int quality, ProfileLevel profile) {
+    if (profile == ProfileLevel::Strong) {
+        return qMax(8, quality - 18);
+    }
+    if (profile == ProfileLevel::Balanced) {
+        return qMax(10, quality - 10);
+    }
+    return quality;
+}
+
+QString normalizeFormat(const QString &format) {
+    const QString lower = format.toLower();
+    return lower == "jpeg" ? QString("jpg") : lower;
+}
+
+QString targetFor(const CompressionPlan &plan, const QString &source) {
+    return plan.outputFormat.isEmpty() || plan.outputFormat == "original" ? source : plan.outputFormat;
+}
+}
+
+CompressionPlan CompressionPlanner::compile(const CompressionOptions &options) {
+    CompressionPlan plan;
+    plan.options = options;
+    plan.profile = parseProfile(options.profile);
+    plan.outputFormat = normalizeFormat(options.outputFormat);
+    const int adjusted = adjustQuality(options.quality, plan.profile);
+    plan.quality = qBound(1, adjusted, 100);
+    plan.encodeQuality = options.lossless ? 100 : plan.quality;
+    plan.pngQuality = qBound(10, adjusted, 100);
+    int rangeSize = 14;
+    plan.pngquantSpeed = 3;
+    int lossy = qMax(0, (100 - plan.quality) * 2);
+    int colors = qMax(32, 256 * plan.quality / 100);
+    plan.pngLevel = 1;
+    if (plan.profile == ProfileLevel::Strong) {
+        rangeSize = 34;
+        plan.pngquantSpeed = 5;
+        lossy = qMin(200, static_cast<int>(lossy * 1.6));
+        colors = qMax(32, static_cast<int>(colors * 0.6));
+        plan.pngLevel = 3;
+    } else if (plan.profile == ProfileLevel::Balanced) {
+        rangeSize = 24;
+        plan.pngquantSpeed = 4;
+        lossy = qMin(200, static_cast<int>(lossy * 1.35));
+        colors = qMax(32, static_cast<int>(colors * 0.75));
+        plan.pngLevel = 2;
+    }
+    plan.pngquantMinQuality = qMin(plan.pngQuality, qMax(20, plan.pngQuality - rangeSize));
+    plan.gifLossy = lossy;
+    plan.gifColors = colors;
+    plan.windows = ToolCatalog::platformKey() == "windows";
+
+    plan.jpegtran = {ToolCatalog::find({"jpegtran"}), {"-copy", "none", "-optimize", "-progressive"}};
+    if (plan.windows) {
+        plan.jpegtran.args << "-trim";
+    }
+    plan.jpegoptim = {plan.windows ? ToolCatalog::find({"jpegoptim"}) : QString(), {"--strip-all", "--all-progressive"}};
+    plan.cjpeg = {
+        ToolCatalog::find({"cjpeg", "mozjpeg"}),
+        {"-quality", QString::number(plan.encodeQuality), "-progressive", "-optimize"}
+    };
+    plan.pngquant = {
+        ToolCatalog::find({"pngquant"}),
+        {
+            "--quality",
+            QString("%1-%2").arg(plan.pngquantMinQuality).arg(plan.pngQuality),
+            "--speed",
+            QString::number(plan.pngquantSpeed),
+            "--strip",
+            "--skip-if-larger"
+        }
+    };
+    plan.oxipng = {ToolCatalog::find({"oxipng"}), {"-o", QString::number(plan.pngLevel), "--strip", "safe"}};
+    plan.optipng = {plan.windows ? ToolCatalog::find({"optipng"}) : QString(), {"-o7", "-strip", "all"}};
+    plan.gifsicle = {ToolCatalog::find({"gifsicle"}), {"-O3", "--no-comments", "--no-names", "--no-extensions"}};
+    plan.cwebp.path = ToolCatalog::find({"cwebp"});
+    if (options.lossless) {
+        plan.cwebp.args = {"-lossless", "-z", "9", "-m", "5", "-metadata", "none"};
+    } else {
+        plan.cwebp.args = {"-q", QString::number(plan.quality), "-m", "5", "-metadata", "none"};
+    }
+    plan.dwebp = {ToolCatalog::find({"dwebp"}), {"-quiet"}};
+
+    for (const QString &source : kFormats) {
+        for (const QString &target : kFormats) {
+            plan.routes.insert(
+                source + ">" + target,
+                EngineRegistry::preferredEngine(plan, source, target)
+            );
+        }
+    }
+    return plan;
+}
+
+QString CompressionPlanner::route(const CompressionPlan &plan, const QString &source, const QString &target) {
+    return plan.routes.value(normalizeFormat(source) + ">" + normalizeFormat(target));
+}
+
+QStringList CompressionPlanner::describe(const CompressionPlan &plan) {
+    QStringList lines;
+    for (const QString &source : kFormats) {
+        const QString target = targetFor(plan, source);
+        lines << QString("%1 → %2：%3").arg(source, target, route(plan, source, target));
+    }
+    return lines;
+}
+
+double CompressionPlanner::estimateCost(const CompressionPlan &plan, const ImageInfo &info, const QString &sourceSuffix) {
+    const QString source = normalizeFormat(info.format.isEmpty() ? sourceSuffix : info.format);
+    const QString target = targetFor(plan, source);
+    double pixels = info.width > 0 && info.height > 0
+        ? static_cast<double>(info.width) * info.height
+        : static_cast<double>(info.size) * 4.0;
+    if (info.animated) {
+        pixels *= 4.0;
+    }
+    double factor = 1.0;
+    if (target == "png") {
+        factor = plan.options.lossless ? 1.5 + plan.pngLevel : 2.0;
+    } else if (target == "webp") {
+        factor = plan.options.lossless ? 4.0 : 1.5;
+    } else if (target == "gif") {
+        factor = 1.5;
+    } else if (plan.options.lossless && source == "jpg") {
+        factor = 0.5;
+    }
+    if (source != target || plan.options.resizeEnabled) {
+        factor += 0.5;
+    }
+    return pixels * factor;
+}
+
+ResourceEstimate CompressionPlanner::estimateMemory(const CompressionPlan &plan, const ImageInfo &info, const QString &sourceSuffix) {
+    const CompressionOptions &options = plan.options;
+    const QString source = normalizeFormat(info.format.isEmpty() ? sourceSuffix : info.format);
+    const QString target = targetFor(plan, source);
+    const qint64 bytesPerPixel = info.bitDepth > 8 ? 8 : 4;
+    qint64 pixels = info.width > 0 && info.height > 0
+        ? static_cast<qint64>(info.width) * info.height
+        : info.size * 4;
+    if (info.animated) {
+        pixels *= 4;
+    }
+    const qint64 decoded = pixels * bytesPerPixel;
+    const qint64 buffers = info.size * 2;
+    if (options.resizeEnabled || source != target) {
+        qint64 scaled = decoded;
+        if (options.resizeEnabled && options.targetWidth > 0 && options.targetHeight > 0) {
+            scaled = static_cast<qint64>(options.targetWidth) * options.targetHeight * bytesPerPixel;
+            if (options.resizeMode == 2) {
+                scaled *= 2;
+            }
+        }
+        return {ResourceClass::Heavy, decoded + scaled * 2 + buffers};
+    }
+    if (target == "webp") {
+        const ResourceClass resourceClass = WebpCodec::isAvailable() ? ResourceClass::Heavy : ResourceClass::Light;
+        return {resourceClass, decoded * (options.lossless ? 4 : 2) + buffers};
+    }
+    if (target == "png") {
+        const bool inProcess = options.lossless ? PngOptimizer::isAvailable() : PngQuantizer::isAvailable();
+        if (inProcess) {
+            return {ResourceClass::Heavy, decoded * 3 + pixels + buffers};
+        }
+        return {ResourceClass::Light, decoded * 2 + buffers};
+    }
+    if (target == "jpg") {
+        return {ResourceClass::Light, pixels * 3 + buffers};
+    }
+    return {ResourceClass::Light, pixels * 2 + buffers};
+}
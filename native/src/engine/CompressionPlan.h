@@ -0,0 +1,62 @@
+#pragma once
+
+#include "EngineRegistry.h"
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+enum class ProfileLevel {
+    High,
+    Balanced,
+    Strong
+};
+
+enum class ResourceClass {
+    Light,
+    Heavy
+};
+
+struct ResourceEstimate {
+    ResourceClass resourceClass;
+    qint64 bytes;
+};
+
+struct ToolPlan {
+    QString path;
+    QStringList args;
+};
+
+struct CompressionPlan {
+    CompressionOptions options;
+    ProfileLevel profile;
+    QString outputFormat;
+    int quality;
+    int encodeQuality;
+    int pngQuality;
+    int pngquantMinQuality;
+    int pngquantSpeed;
+    int gifLossy;
+    int gifColors;
+    int pngLevel;
+    bool windows;
+    ToolPlan jpegtran;
+    ToolPlan jpegoptim;
+    ToolPlan cjpeg;
+    ToolPlan pngquant;
+    ToolPlan oxipng;
+    ToolPlan optipng;
+    ToolPlan gifsicle;
+    ToolPlan cwebp;
+    ToolPlan dwebp;
+    QHash<QString, QString> routes;
+};
+
+class CompressionPlanner {
+public:
+    static CompressionPlan compile(const CompressionOptions &options);
+    static QString route(const CompressionPlan &plan, const QString &source, const QString &target);
+    static QStringList describe(const CompressionPlan &plan);
+    static double estimateCost(const CompressionPlan &plan, const ImageInfo &info, const QString &sourceSuffix);
+    static ResourceEstimate estimateMemory(const CompressionPlan &plan, const ImageInfo &info, const QString &sourceSuffix);
+};
@@ -0,0 +1,76 @@
+#include "CpuBudget.h"
+
+#include <QMutexLocker>
+#include <QtGlobal>
+
+#include <limits>
+
+CpuBudget::Lease::Lease(CpuBudget *budget, int wanted)
+    : owner(budget),
+      extra(budget ? budget->acquire(wanted) : 0) {}
+
+CpuBudget::Lease::~Lease() {
+    if (owner) {
+        owner->release(extra);
+    }
+}
+
+int CpuBudget::Lease::threads() const {
+    return 1 + extra;
+}
+
+CpuBudget::CpuBudget(int tokenCount, int workerCount)
+    : total(qMax(1, tokenCount)),
+      workers(qMax(1, workerCount)),
+      remaining(std::numeric_limits<int>::max()),
+      active(0),
+      leased(0),
+      boosted(0) {}
+
+void CpuBudget::setRemaining(int files) {
+    QMutexLocker locker(&mutex);
+    remaining = qMax(1, files);
+}
+
+void CpuBudget::enter() {
+    QMutexLocker locker(&mutex);
+    active += 1;
+}
+
+void CpuBudget::leave() {
+    QMutexLocker locker(&mutex);
+    active -= 1;
+}
+
+int CpuBudget::tokens() const {
+    QMutexLocker locker(&mutex);
+    return total;
+}
+
+int CpuBudget::boostedCount() const {
+    QMutexLocker locker(&mutex);
+    return boosted;
+}
+
+int CpuBudget::acquire(int wanted) {
+    if (wanted <= 1) {
+        return 0;
+    }
+    QMutexLocker locker(&mutex);
+    const int share = total / qMin(remaining, workers);
+    const int idle = total - qMax(1, active) - leased;
+    const int extra = qMax(0, qMin(qMin(wanted, share) - 1, idle));
+    leased += extra;
+    if (extra > 0 && remaining < workers) {
+        boosted += 1;
+    }
+    return extra;
+}
+
+void CpuBudget::release(int count) {
+    if (count <= 0) {
+        return;
+    }
+    QMutexLocker locker(&mutex);
+    leased -= count;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QMutex>
+
+class CpuBudget {
+public:
+    class Lease {
+    public:
+        Lease(CpuBudget *budget, int wanted);
+        ~Lease();
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        int threads() const;
+
+    private:
+        CpuBudget *owner;
+        int extra;
+    };
+
+    CpuBudget(int tokenCount, int workerCount);
+    CpuBudget(const CpuBudget &) = delete;
+    CpuBudget &operator=(const CpuBudget &) = delete;
+
+    void setRemaining(int files);
+    void enter();
+    void leave();
+    int tokens() const;
+    int boostedCount() const;
+
+private:
+    int acquire(int wanted);
+    void release(int count);
+
+    mutable QMutex mutex;
+    int total;
+    int workers;
+    int remaining;
+    int active;
+    int leased;
+    int boosted;
+};
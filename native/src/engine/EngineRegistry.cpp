@@ -1,80 +1,36 @@
 #include "EngineRegistry.h"
 
+#include "CompressionPlan.h"
+#include "CpuBudget.h"
+#include "FastHash.h"
+#include "JpegCodec.h"
+#include "OutputCache.h"
+#include "PngEncoder.h"
+#include "PngOptimizer.h"
+#include "PngQuantizer.h"
+#include "ProcessLauncher.h"
+#include "ToolCatalog.h"
+#include "WebpCodec.h"
+
+#include <QBuffer>
 #include <QCoreApplication>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QPair>
-#include <QProcess>
+#include <QSaveFile>
 #include <QSysInfo>
 #include <QTemporaryFile>
 #include <QScopedPointer>
 #include <QCryptographicHash>
+#include <QImage>
 #include <QImageReader>
+#include <QImageWriter>
 
 namespace {
 const int kProcessTimeoutMs = 180000;
-QString normalizeProfile(const QString &profile) {
-    if (profile.contains("强")) {
-        return "strong";
-    }
-    if (profile.contains("均衡")) {
-        return "balanced";
-    }
-    if (profile == "strong" || profile == "balanced" || profile == "high") {
-        return profile;
-    }
-    return "high";
-}
-
-int adjustQuality(int quality, const QString &profile) {
-    const QString normalized = normalizeProfile(profile);
-    if (normalized == "strong") {
-        return qMax(8, quality - 18);
-    }
-    if (normalized == "balanced") {
-        return qMax(10, quality - 10);
-    }
-    return quality;
-}
-
-QPair<int, int> getPngquantSettings(const QString &profile, int quality) {
-    const QString normalized = normalizeProfile(profile);
-    int rangeSize = 14;
-    int speed = 3;
-    if (normalized == "strong") {
-        rangeSize = 34;
-        speed = 5;
-    } else if (normalized == "balanced") {
-        rangeSize = 24;
-        speed = 4;
-    }
-    const int minQ = qMax(20, quality - rangeSize);
-    return qMakePair(minQ, speed);
-}
-
-int adjustLossy(const QString &profile, int lossy) {
-    const QString normalized = normalizeProfile(profile);
-    if (normalized == "strong") {
-        return qMin(200, static_cast<int>(lossy * 1.6));
-    }
-    if (normalized == "balanced") {
-        return qMin(200, static_cast<int>(lossy * 1.35));
-    }
-    return lossy;
-}
-
-int adjustColors(const QString &profile, int colors) {
-    const QString normalized = normalizeProfile(profile);
-    if (normalized == "strong") {
-        return qMax(32, static_cast<int>(colors * 0.6));
-    }
-    if (normalized == "balanced") {
-        return qMax(32, static_cast<int>(colors * 0.75));
-    }
-    return colors;
-}
-
+const int kBatchFileTimeoutMs = 10000;
+const int kWebpThreads = 2;
 QString normalizeSuffix(const QString &suffix) {
     if (suffix == "jpeg") {
         return "jpg";
@@ -95,135 +51,197 @@ bool isCorruptedInput(const QString &output) {
         || text.contains("bad huffman")
         || text.contains("unexpected end")
         || text.contains("read error")
+        || text.contains("crc error")
         || text.contains("missing");
 }
 
-QString detectPlatform() {
-    const QString product = QSysInfo::productType().toLower();
-    if (product == "osx" || product == "macos" || product == "darwin") {
-        return "macos";
+bool runProcess(const QString &program, const QStringList &args) {
+    return ProcessLauncher::run(program, args, kProcessTimeoutMs).code == 0;
+}
+
+Task<QPair<bool, QString>> runProcessWithOutput(const QString &program, const QStringList &args) {
+    const ProcessResult result = co_await ProcessLauncher::start(program, args, kProcessTimeoutMs);
+    co_return qMakePair(result.code == 0, QString::fromUtf8(result.output));
+}
+
+Task<QPair<int, QString>> runProcessWithCode(const QString &program, const QStringList &args) {
+    const ProcessResult result = co_await ProcessLauncher::start(program, args, kProcessTimeoutMs);
+    co_return qMakePair(result.code, QString::fromUtf8(result.output));
+}
+
+Task<ProcessResult> runProcessCapped(
+    const QString &program,
+    const QStringList &args,
+    const QString &output,
+    qint64 byteLimit,
+    qint64 inputBytes
+) {
+    const QVector<ProcessCommand> commands = {{program, args}};
+    ProcessResult result{-1, QByteArray(), 0};
+    if (byteLimit > 0) {
+        result = co_await ProcessLauncher::startToFile(commands, QByteArray(), output, byteLimit, kProcessTimeoutMs);
+    } else {
+        result = co_await ProcessLauncher::start(program, args, kProcessTimeoutMs);
     }
-    if (product == "windows" || product == "win") {
-        return "windows";
+    if (result.code == 0) {
+        ProcessLauncher::recordCpu(program, result.cpuMs, inputBytes);
     }
-    if (product == "linux") {
-        return "linux";
+    co_return result;
+}
+
+bool readFileBytes(const QString &path, QByteArray *data) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
     }
-    return product;
+    *data = file.readAll();
+    return true;
 }
 
-QString detectArch() {
-    const QString arch = QSysInfo::currentCpuArchitecture().toLower();
-    if (arch.contains("arm64") || arch.contains("aarch64")) {
-        return "arm64";
+bool writeFileBytes(const QString &path, const QByteArray &data) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
     }
-    if (arch.contains("x86_64") || arch.contains("amd64")) {
-        return "x64";
+    if (file.write(data) != data.size()) {
+        file.cancelWriting();
+        return false;
     }
-    return arch;
+    return file.commit();
 }
 
-QStringList collectVendorBases(const QDir &startDir, const QString &platformKey, const QString &archKey) {
-    QStringList bases;
-    QDir current = startDir;
-    for (int depth = 0; depth < 8; ++depth) {
-        const QString vendorRoot = current.filePath("vendor");
-        if (QDir(vendorRoot).exists()) {
-            bases << vendorRoot
-                  << QDir(vendorRoot).filePath(QString("%1/%2").arg(platformKey, archKey))
-                  << QDir(vendorRoot).filePath(QString("%1").arg(platformKey));
-        }
-        if (!current.cdUp()) {
-            break;
-        }
+QString nativeJpegEngine() {
+    return QString("%1(内置)").arg(JpegCodec::backendName());
+}
+
+WebpEncodeSettings webpSettings(const CompressionPlan &plan, int threads) {
+    return {plan.options.lossless, plan.quality, 5, threads > 1 ? 1 : 0};
+}
+
+PngOptimizeSettings pngOptimizeSettings(const CompressionPlan &plan, int threads) {
+    return {plan.pngLevel, threads};
+}
+
+QStringList threadArgs(const QString &tool, int threads) {
+    if (tool == "cwebp" && threads <= 1) {
+        return {};
     }
-    return bases;
+    if (!ToolCatalog::info(tool).threads) {
+        return {};
+    }
+    if (tool == "oxipng") {
+        return {"--threads", QString::number(threads)};
+    }
+    return {"-mt"};
 }
 
-QString findTool(const QStringList &names) {
-    const QString appDir = QCoreApplication::applicationDirPath();
-    const QString platformKey = detectPlatform();
-    const QString archKey = detectArch();
-    QStringList baseDirs = {
-        appDir,
-        QDir(appDir).filePath("vendor"),
-        QDir(appDir).filePath(QString("vendor/%1/%2").arg(platformKey, archKey)),
-        QDir(appDir).filePath(QString("vendor/%1").arg(platformKey)),
-        QDir(appDir).filePath("../Resources"),
-        QDir(appDir).filePath("../Resources/vendor"),
-        QDir(appDir).filePath(QString("../Resources/vendor/%1/%2").arg(platformKey, archKey)),
-        QDir(appDir).filePath(QString("../Resources/vendor/%1").arg(platformKey)),
-        QDir(appDir).filePath("../MacOS"),
-        QDir(appDir).filePath("../MacOS/vendor"),
-        QDir(appDir).filePath(QString("../MacOS/vendor/%1/%2").arg(platformKey, archKey)),
-        QDir(appDir).filePath(QString("../MacOS/vendor/%1").arg(platformKey)),
-        QDir(appDir).filePath("../Frameworks"),
-        QDir(appDir).filePath("../Frameworks/vendor"),
-        QDir(appDir).filePath(QString("../Frameworks/vendor/%1/%2").arg(platformKey, archKey)),
-        QDir(appDir).filePath(QString("../Frameworks/vendor/%1").arg(platformKey)),
-    };
-    baseDirs += collectVendorBases(QDir(appDir), platformKey, archKey);
-    for (const QString &base : baseDirs) {
-        for (const QString &name : names) {
-            const QString candidate = QDir(base).filePath(name);
-            if (QFileInfo::exists(candidate)) {
-                return candidate;
-            }
-            const QString exeCandidate = QDir(base).filePath(name + ".exe");
-            if (QFileInfo::exists(exeCandidate)) {
-                return exeCandidate;
-            }
+bool encodeImageBytes(
+    const QImage &image,
+    const QString &format,
+    int quality,
+    bool lossless,
+    CpuBudget *budget,
+    QByteArray *data,
+    QString *error
+) {
+    if (format == "jpg" && JpegCodec::isAvailable()) {
+        return JpegCodec::encode(image, {quality, true, true, true}, data, error);
+    }
+    if (format == "png" && PngEncoder::isAvailable()) {
+        return PngEncoder::encode(PngEncoder::imageData(image), {PngFilter::Adaptive, 9, PngStrategy::Default}, data, error);
+    }
+    if (format == "webp" && WebpCodec::isAvailable()) {
+        const CpuBudget::Lease lease(budget, kWebpThreads);
+        return WebpCodec::encode(image, {lossless, quality, 5, lease.threads() > 1 ? 1 : 0}, 0, data, error)
+            == WebpCodec::Status::Success;
+    }
+    data->clear();
+    QBuffer buffer(data);
+    if (!buffer.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QImageWriter writer(&buffer, format.toLatin1());
+    writer.setQuality(quality);
+    if (!writer.write(image)) {
+        if (error) {
+            *error = writer.errorString();
         }
+        return false;
     }
-    return {};
+    return true;
 }
 
-bool runProcess(const QString &program, const QStringList &args) {
-    QProcess process;
-    process.setProgram(program);
-    process.setArguments(args);
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    process.start();
-    if (!process.waitForFinished(kProcessTimeoutMs)) {
-        process.kill();
-        process.waitForFinished(2000);
+QByteArray pnmBytes(const QImage &image, bool keepAlpha) {
+    QImage converted;
+    QByteArray data;
+    qsizetype rowBytes = 0;
+    if (keepAlpha && image.hasAlphaChannel()) {
+        converted = image.convertToFormat(QImage::Format_RGBA8888);
+        data = QString("P7\nWIDTH %1\nHEIGHT %2\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n")
+            .arg(converted.width())
+            .arg(converted.height())
+            .toLatin1();
+        rowBytes = static_cast<qsizetype>(converted.width()) * 4;
+    } else if (image.format() == QImage::Format_Grayscale8 || image.format() == QImage::Format_Grayscale16) {
+        converted = image.convertToFormat(QImage::Format_Grayscale8);
+        data = QString("P5\n%1 %2\n255\n").arg(converted.width()).arg(converted.height()).toLatin1();
+        rowBytes = converted.width();
+    } else {
+        converted = image.convertToFormat(QImage::Format_RGB888);
+        data = QString("P6\n%1 %2\n255\n").arg(converted.width()).arg(converted.height()).toLatin1();
+        rowBytes = static_cast<qsizetype>(converted.width()) * 3;
+    }
+    data.reserve(data.size() + rowBytes * converted.height());
+    for (int y = 0; y < converted.height(); y += 1) {
+        data.append(reinterpret_cast<const char *>(converted.constScanLine(y)), rowBytes);
+    }
+    return data;
+}
+
+bool decodeWebpFile(const QString &path, QImage *image, QString *error) {
+    QByteArray data;
+    if (!readFileBytes(path, &data)) {
+        if (error) {
+            *error = "无法读取文件";
+        }
         return false;
     }
-    return process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+    return WebpCodec::decode(data, image, error);
 }
 
-QPair<bool, QString> runProcessWithOutput(const QString &program, const QStringList &args) {
-    QProcess process;
-    process.setProgram(program);
-    process.setArguments(args);
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    process.start();
-    bool finished = process.waitForFinished(kProcessTimeoutMs);
-    if (!finished) {
-        process.kill();
-        process.waitForFinished(2000);
+QString batchTool(const QString &suffix, const CompressionPlan &plan) {
+    if (suffix == "png") {
+        if (plan.options.lossless) {
+            return PngOptimizer::isAvailable() ? QString() : plan.oxipng.path;
+        }
+        return PngQuantizer::isAvailable() ? QString() : plan.pngquant.path;
     }
-    const bool ok = process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
-    const QString output = QString::fromUtf8(process.readAllStandardOutput());
-    return qMakePair(ok, output);
+    if (suffix == "gif") {
+        return plan.gifsicle.path;
+    }
+    return {};
 }
 
-QPair<int, QString> runProcessWithCode(const QString &program, const QStringList &args) {
-    QProcess process;
-    process.setProgram(program);
-    process.setArguments(args);
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    process.start();
-    int code = -1;
-    if (process.waitForFinished(kProcessTimeoutMs)) {
-        code = process.exitStatus() == QProcess::NormalExit ? process.exitCode() : -1;
+QStringList gifsicleLossyArgs(int lossy, int colors) {
+    return {QString("--lossy=%1").arg(lossy), QString("--colors=%1").arg(colors)};
+}
+
+QStringList batchArgs(const QString &suffix, const CompressionPlan &plan, const QStringList &files, int threads) {
+    QStringList args;
+    if (suffix == "png" && plan.options.lossless) {
+        args = plan.oxipng.args;
+        args << threadArgs("oxipng", threads);
+    } else if (suffix == "png") {
+        args = plan.pngquant.args;
+        args << "--ext" << ".png" << "--force";
     } else {
-        process.kill();
-        process.waitForFinished(2000);
-        code = -2;
+        args = QStringList{"--batch"} + plan.gifsicle.args;
+        if (!plan.options.lossless) {
+            args << gifsicleLossyArgs(plan.gifLossy, plan.gifColors);
+        }
     }
-    const QString output = QString::fromUtf8(process.readAllStandardOutput());
-    return qMakePair(code, output);
+    args << files;
+    return args;
 }
 
 CompressionResult keepOriginal(const QString &source, const QString &output, const QString &message) {
@@ -242,10 +260,140 @@ CompressionResult copyOriginal(const QString &source, const QString &output) {
     return {true, originalSize, outputSize, "原图", "缺少引擎，已保留原图"};
 }
 
+qint64 outputLimit(
+    const QString &source,
+    const QString &output,
+    const QString &suffix,
+    const CompressionOptions &options,
+    qint64 originalSize
+) {
+    if (options.abortPercent <= 0
+        || !isSameFormat(normalizeSuffix(options.outputFormat.toLower()), suffix)
+        || QFileInfo(source).absoluteFilePath() == QFileInfo(output).absoluteFilePath()) {
+        return 0;
+    }
+    return qMax<qint64>(1, originalSize * options.abortPercent / 100);
+}
+
+qint64 savedCpuMs(const QString &program, const ProcessResult &result, qint64 inputBytes) {
+    return qMax<qint64>(0, ProcessLauncher::estimateCpuMs(program, inputBytes) - result.cpuMs);
+}
+
+CompressionResult abortedEncode(
+    const QString &source,
+    const QString &output,
+    const QString &engine,
+    qint64 cpuSavedMs
+) {
+    CompressionResult kept = keepOriginal(source, output, QString("%1 输出超过目标体积，已提前终止并保留原图").arg(engine));
+    kept.aborted = true;
+    kept.cpuSavedMs = cpuSavedMs;
+    return kept;
+}
+
 CompressionResult missingEngine(const QString &source, const QString &engine) {
     const qint64 originalSize = QFileInfo(source).size();
     return {false, originalSize, originalSize, engine, "缺少引擎"};
 }
+
+QString cacheKeyFor(const QString &source, const ImageInfo &info, const CompressionOptions &options) {
+    if (!OutputCache::isEnabled()) {
+        return QString();
+    }
+    bool ok = info.hashed;
+    const quint64 contentHash = ok ? info.contentHash : FastHash::hashFile(source, &ok);
+    if (!ok) {
+        return QString();
+    }
+    return OutputCache::key(contentHash, info.size, EngineRegistry::optionsFingerprint(options));
+}
+
+bool restoreCached(const QString &key, qint64 originalSize, const QString &output, CompressionResult *result) {
+    CachedOutput cached;
+    if (key.isEmpty() || !OutputCache::fetch(key, &cached) || !writeFileBytes(output, cached.data)) {
+        return false;
+    }
+    *result = {true, originalSize, cached.data.size(), cached.engine, QString("%1（缓存命中）").arg(cached.message)};
+    return true;
+}
+
+void storeCached(const QString &key, const QString &output, const CompressionResult &result) {
+    if (key.isEmpty() || !result.success) {
+        return;
+    }
+    QFile file(output);
+    if (file.open(QIODevice::ReadOnly)) {
+        OutputCache::store(key, {file.readAll(), result.engine, result.message});
+    }
+}
+
+QString missing(const QString &tool) {
+    return QString("缺少 %1").arg(tool);
+}
+
+QString sameFormatEngine(const CompressionPlan &plan, const QString &format) {
+    const bool lossless = plan.options.lossless;
+    if (format == "jpg") {
+        if (lossless) {
+            return JpegCodec::isAvailable() ? QString("jpegtran(内置)")
+                : (!plan.jpegtran.path.isEmpty() ? QString("jpegtran") : missing("jpegtran"));
+        }
+        return JpegCodec::isAvailable() ? nativeJpegEngine()
+            : (!plan.cjpeg.path.isEmpty() ? QString("mozjpeg") : missing("mozjpeg"));
+    }
+    if (format == "png") {
+        if (!lossless) {
+            return PngQuantizer::isAvailable() ? QString("pngquant(内置)")
+                : (!plan.pngquant.path.isEmpty() ? QString("pngquant") : missing("pngquant"));
+        }
+        if (PngOptimizer::isAvailable()) {
+            return "libpng(内置)";
+        }
+        if (!plan.oxipng.path.isEmpty()) {
+            return "oxipng";
+        }
+        return plan.windows && !plan.optipng.path.isEmpty() ? QString("optipng") : missing("oxipng/optipng");
+    }
+    if (format == "gif") {
+        return !plan.gifsicle.path.isEmpty() ? QString("gifsicle") : missing("gifsicle");
+    }
+    return WebpCodec::isAvailable() ? QString("libwebp(内置)")
+        : (!plan.cwebp.path.isEmpty() ? QString("cwebp") : missing("cwebp"));
+}
+
+QString conversionEngine(const CompressionPlan &plan, const QString &source, const QString &target) {
+    if (target == "gif") {
+        return "不支持转换为GIF";
+    }
+    if (target == "webp") {
+        return WebpCodec::isAvailable() ? QString("libwebp(内置)")
+            : (!plan.cwebp.path.isEmpty() ? QString("cwebp") : missing("cwebp"));
+    }
+    if (source == "webp") {
+        if (WebpCodec::isAvailable()) {
+            return target == "jpg" && JpegCodec::isAvailable()
+                ? QString("libwebp+%1").arg(nativeJpegEngine())
+                : QString("libwebp(内置)");
+        }
+        if (plan.dwebp.path.isEmpty()) {
+            return missing("dwebp");
+        }
+        if (target == "png") {
+            return "dwebp";
+        }
+        return !plan.cjpeg.path.isEmpty() ? QString("dwebp+mozjpeg") : missing("mozjpeg");
+    }
+    if (target == "jpg") {
+        return JpegCodec::isAvailable() ? nativeJpegEngine()
+            : (!plan.cjpeg.path.isEmpty() ? QString("mozjpeg") : QString("Qt"));
+    }
+    return QString("%1 + %2")
+        .arg(PngEncoder::isAvailable() ? QString("libpng(内置)") : QString("Qt"), sameFormatEngine(plan, "png"));
+}
+}
+
+QString EngineRegistry::preferredEngine(const CompressionPlan &plan, const QString &source, const QString &target) {
+    return source == target ? sameFormatEngine(plan, source) : conversionEngine(plan, source, target);
 }
 
 QStringList EngineRegistry::availableEngines() {
@@ -253,34 +401,37 @@ QStringList EngineRegistry::availableEngines() {
 }
 
 bool EngineRegistry::toolExists(const QString &name) {
-    return !findTool({name}).isEmpty();
+    return !ToolCatalog::find({name}).isEmpty();
 }
 
 QString EngineRegistry::engineStatus(bool lossless) {
-    const QString jpegtran = findTool({"jpegtran"});
-    const QString cjpeg = findTool({"cjpeg", "mozjpeg"});
-    const QString pngquant = findTool({"pngquant"});
-    const QString oxipng = findTool({"oxipng"});
-    const QString optipng = findTool({"optipng"});
-    const QString gifsicle = findTool({"gifsicle"});
-    const QString cwebp = findTool({"cwebp"});
-    const QString dwebp = findTool({"dwebp"});
-    const QString jpgLossless = jpegtran.isEmpty() ? "不可用" : "jpegtran";
-    const QString jpgLossy = cjpeg.isEmpty() ? "不可用" : "mozjpeg";
-    const QString pngLossless = !oxipng.isEmpty() ? "oxipng" : (!optipng.isEmpty() ? "optipng" : "不可用");
-    const QString pngLossy = pngquant.isEmpty() ? "不可用" : "pngquant";
+    const QString jpegtran = ToolCatalog::find({"jpegtran"});
+    const QString cjpeg = ToolCatalog::find({"cjpeg", "mozjpeg"});
+    const QString pngquant = ToolCatalog::find({"pngquant"});
+    const QString oxipng = ToolCatalog::find({"oxipng"});
+    const QString optipng = ToolCatalog::find({"optipng"});
+    const QString gifsicle = ToolCatalog::find({"gifsicle"});
+    const QString cwebp = ToolCatalog::find({"cwebp"});
+    const QString dwebp = ToolCatalog::find({"dwebp"});
+    const QString jpgLossless = JpegCodec::isAvailable() ? "jpegtran(内置)" : (jpegtran.isEmpty() ? "不可用" : "jpegtran");
+    const QString jpgLossy = JpegCodec::isAvailable() ? nativeJpegEngine() : (cjpeg.isEmpty() ? "不可用" : "mozjpeg");
+    const QString pngLossless = PngOptimizer::isAvailable()
+        ? "libpng(内置)"
+        : (!oxipng.isEmpty() ? "oxipng" : (!optipng.isEmpty() ? "optipng" : "不可用"));
+    const QString pngLossy = PngQuantizer::isAvailable() ? "pngquant(内置)" : (pngquant.isEmpty() ? "不可用" : "pngquant");
     const QString gifEngine = gifsicle.isEmpty() ? "不可用" : "gifsicle";
-    const QString webpEncode = cwebp.isEmpty() ? "不可用" : "cwebp";
-    const QString webpDecode = dwebp.isEmpty() ? "不可用" : "dwebp";
+    const QString webpEncode = WebpCodec::isAvailable() ? "libwebp(内置)" : (cwebp.isEmpty() ? "不可用" : "cwebp");
+    const QString webpDecode = WebpCodec::isAvailable() ? "libwebp(内置)" : (dwebp.isEmpty() ? "不可用" : "dwebp");
     const QString mode = lossless ? "无损优先" : "有损优先";
     const QString appDir = QCoreApplication::applicationDirPath();
-    const QString platformKey = detectPlatform();
-    const QString archKey = detectArch();
+    const QString platformKey = ToolCatalog::platformKey();
+    const QString archKey = ToolCatalog::archKey();
     const QString productType = QSysInfo::productType();
     const QString resourceVendor = QDir(appDir).filePath(QString("../Resources/vendor/%1/%2").arg(platformKey, archKey));
     const bool anyFound = !jpegtran.isEmpty() || !cjpeg.isEmpty() || !pngquant.isEmpty()
         || !oxipng.isEmpty() || !optipng.isEmpty() || !gifsicle.isEmpty() || !cwebp.isEmpty()
-        || !dwebp.isEmpty();
+        || !dwebp.isEmpty() || JpegCodec::isAvailable() || PngQuantizer::isAvailable()
+        || PngOptimizer::isAvailable() || WebpCodec::isAvailable();
     QString status = QString("引擎状态(%1)：JPG 无损(%2) 有损(%3)；PNG 无损(%4) 有损(%5)；GIF(%6)；WebP 编码(%7) 解码(%8)")
         .arg(mode, jpgLossless, jpgLossy, pngLossless, pngLossy, gifEngine, webpEncode, webpDecode);
     status += QString(" | 平台 %1/%2(%3)").arg(platformKey, archKey, productType);
@@ -291,54 +442,157 @@ QString EngineRegistry::engineStatus(bool lossless) {
     return status;
 }
 
-CompressionResult EngineRegistry::compressFile(
+QString EngineRegistry::engineSignature() {
+    QStringList parts;
+    parts << QString("jpeg=%1").arg(JpegCodec::isAvailable() ? nativeJpegEngine() : QString("-"))
+          << QString("pngquant=%1").arg(PngQuantizer::isAvailable() ? 1 : 0)
+          << QString("libpng=%1").arg(PngOptimizer::isAvailable() ? 1 : 0)
+          << QString("libwebp=%1").arg(WebpCodec::isAvailable() ? 1 : 0);
+    const QStringList tools = {"jpegtran", "cjpeg", "pngquant", "oxipng", "optipng", "gifsicle", "cwebp", "dwebp"};
+    for (const QString &name : tools) {
+        const ToolInfo info = ToolCatalog::info(name);
+        parts << QString("%1=%2").arg(name, info.path.isEmpty() ? QString("-") : info.version);
+    }
+    return parts.join(';');
+}
+
+quint64 EngineRegistry::optionsFingerprint(const CompressionOptions &options) {
+    const QByteArray key = QString("%1|%2|%3|%4|%5|%6|%7|%8|%9")
+        .arg(options.lossless ? 1 : 0)
+        .arg(options.quality)
+        .arg(options.profile)
+        .arg(options.outputFormat.toLower())
+        .arg(options.resizeEnabled ? 1 : 0)
+        .arg(options.targetWidth)
+        .arg(options.targetHeight)
+        .arg(options.resizeMode)
+        .arg(options.abortPercent)
+        .toUtf8();
+    return FastHash::hash(key.constData(), key.size());
+}
+
+bool EngineRegistry::canEncodeWebp() {
+    return WebpCodec::isAvailable() || !ToolCatalog::find({"cwebp"}).isEmpty();
+}
+
+bool EngineRegistry::canDecodeWebp() {
+    return WebpCodec::isAvailable() || !ToolCatalog::find({"dwebp"}).isEmpty();
+}
+
+bool EngineRegistry::canResizeWebp() {
+    return WebpCodec::isAvailable();
+}
+
+QImage EngineRegistry::readImage(const QString &path, const QString &format) {
+    if (format == "webp" && WebpCodec::isAvailable()) {
+        QImage image;
+        if (decodeWebpFile(path, &image, nullptr)) {
+            return image;
+        }
+    }
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    if (!format.isEmpty()) {
+        reader.setFormat(format.toLatin1());
+    }
+    return reader.read();
+}
+
+bool EngineRegistry::writeImage(const QImage &image, const QString &path, const QString &format, int quality) {
+    QByteArray data;
+    if (!encodeImageBytes(image, format, quality, quality >= 100, nullptr, &data, nullptr)) {
+        return false;
+    }
+    return writeFileBytes(path, data);
+}
+
+Task<CompressionResult> EngineRegistry::compressFile(
     const QString &source,
     const QString &output,
-    const CompressionOptions &options
+    const CompressionPlan &plan,
+    const ImageInfo &info,
+    CpuBudget *budget
 ) {
-    const QString suffixFromName = normalizeSuffix(QFileInfo(source).suffix().toLower());
-    const QByteArray detected = QImageReader::imageFormat(source);
-    const QString actualSuffix = normalizeSuffix(QString::fromLatin1(detected).toLower());
-    const QString suffix = actualSuffix.isEmpty() ? suffixFromName : actualSuffix;
-    const qint64 originalSize = QFileInfo(source).size();
-    const QString outputFormat = normalizeSuffix(options.outputFormat.toLower());
+    const QString key = cacheKeyFor(source, info, plan.options);
+    CompressionResult result;
+    if (restoreCached(key, info.size, output, &result)) {
+        co_return result;
+    }
+    result = co_await compressWithEngines(source, output, plan, info, budget);
+    storeCached(key, output, result);
+    co_return result;
+}
+
+Task<CompressionResult> EngineRegistry::compressWithEngines(
+    const QString &source,
+    const QString &output,
+    const CompressionPlan &plan,
+    const ImageInfo &info,
+    CpuBudget *budget
+) {
+    const CompressionOptions &options = plan.options;
+    const QString suffix = normalizeSuffix(info.format.isEmpty() ? QFileInfo(source).suffix().toLower() : info.format);
+    const qint64 originalSize = info.size;
+    const QString &outputFormat = plan.outputFormat;
     if (outputFormat == "gif" && suffix != "gif") {
-        return {false, originalSize, originalSize, "gifsicle", "不支持转换为GIF"};
+        co_return {false, originalSize, originalSize, "gifsicle", "不支持转换为GIF"};
     }
     if (outputFormat == "webp" && suffix != "webp") {
-        const QString cwebp = findTool({"cwebp"});
-        if (cwebp.isEmpty()) {
-            return missingEngine(source, "cwebp");
+        if (WebpCodec::isAvailable()) {
+            const CpuBudget::Lease lease(budget, kWebpThreads);
+            QImageReader reader(source);
+            const QImage image = reader.read();
+            QByteArray encoded;
+            if (!image.isNull()
+                && WebpCodec::encode(image, webpSettings(plan, lease.threads()), 0, &encoded, nullptr) == WebpCodec::Status::Success
+                && writeFileBytes(output, encoded)) {
+                co_return {true, originalSize, encoded.size(), "libwebp(内置)", "成功"};
+            }
         }
-        QStringList args;
-        if (options.lossless) {
-            args = {"-lossless", "-z", "9", "-m", "5", "-metadata", "none", source, "-o", output};
-        } else {
-            const int quality = qBound(1, adjustQuality(options.quality, options.profile), 100);
-            args = {"-q", QString::number(quality), "-m", "5", "-metadata", "none", source, "-o", output};
+        const QString &cwebp = plan.cwebp.path;
+        if (cwebp.isEmpty()) {
+            co_return missingEngine(source, "cwebp");
         }
-        const auto res = runProcessWithCode(cwebp, args);
+        const CpuBudget::Lease lease(budget, kWebpThreads);
+        QStringList args = plan.cwebp.args;
+        args << threadArgs("cwebp", lease.threads()) << source << "-o" << output;
+        const auto res = co_await runProcessWithCode(cwebp, args);
         const bool ok = res.first == 0;
         if (res.first == -2) {
-            return {false, originalSize, originalSize, "cwebp", "执行超时"};
+            co_return {false, originalSize, originalSize, "cwebp", "执行超时"};
         }
         const qint64 outputSize = QFileInfo(output).size();
         if (!ok && isSameFormat(outputFormat, suffix) && isCorruptedInput(res.second)) {
-            return keepOriginal(source, output, "源文件异常，已保留原图");
+            co_return keepOriginal(source, output, "源文件异常，已保留原图");
         }
-        return {ok, originalSize, outputSize, "cwebp", ok ? "成功" : "失败"};
+        co_return {ok, originalSize, outputSize, "cwebp", ok ? "成功" : "失败"};
     }
     if (suffix == "webp" && (outputFormat == "jpg" || outputFormat == "png")) {
-        const QString dwebp = findTool({"dwebp"});
+        if (WebpCodec::isAvailable()) {
+            QImage image;
+            QString error;
+            if (decodeWebpFile(source, &image, &error)) {
+                QByteArray encoded;
+                if (encodeImageBytes(image, outputFormat, plan.encodeQuality, options.lossless, budget, &encoded, &error)
+                    && writeFileBytes(output, encoded)) {
+                    const QString engine = outputFormat == "jpg" && JpegCodec::isAvailable()
+                        ? QString("libwebp+%1").arg(nativeJpegEngine())
+                        : QString("libwebp(内置)");
+                    co_return {true, originalSize, encoded.size(), engine, "成功"};
+                }
+            }
+        }
+        const QString &dwebp = plan.dwebp.path;
         if (dwebp.isEmpty()) {
-            return {false, originalSize, originalSize, "dwebp", "不支持：缺少 dwebp"};
+            co_return {false, originalSize, originalSize, "dwebp", "不支持：缺少 dwebp"};
         }
         if (outputFormat == "png") {
-            const QStringList args = {"-quiet", "-png", source, "-o", output};
-            const auto res = runProcessWithCode(dwebp, args);
+            QStringList args = plan.dwebp.args;
+            args << "-png" << source << "-o" << output;
+            const auto res = co_await runProcessWithCode(dwebp, args);
             const bool ok = res.first == 0;
             if (res.first == -2) {
-                return {false, originalSize, originalSize, "dwebp", "执行超时"};
+                co_return {false, originalSize, originalSize, "dwebp", "执行超时"};
             }
             const qint64 outputSize = QFileInfo(output).size();
             QString msg = ok ? "成功" : "失败";
@@ -348,50 +602,23 @@ CompressionResult EngineRegistry::compressFile(
                     msg = tail;
                 }
             }
-            return {ok, originalSize, outputSize, "dwebp", msg};
+            co_return {ok, originalSize, outputSize, "dwebp", msg};
         }
-        const QString cjpeg = findTool({"cjpeg", "mozjpeg"});
+        const QString &cjpeg = plan.cjpeg.path;
         if (cjpeg.isEmpty()) {
-            return missingEngine(source, "mozjpeg");
+            co_return missingEngine(source, "mozjpeg");
         }
-        QScopedPointer<QTemporaryFile> temp(new QTemporaryFile(QDir(QFileInfo(output).absolutePath()).filePath(".imgcompress_tmp_XXXXXX.ppm")));
-        temp->setAutoRemove(true);
-        if (!temp->open()) {
-            temp.reset(new QTemporaryFile(QDir(QDir::tempPath()).filePath("imgcompress_tmp_XXXXXX.ppm")));
-            temp->setAutoRemove(true);
-            if (!temp->open()) {
-                return {false, originalSize, originalSize, "dwebp", "无法创建临时文件"};
-            }
-        }
-        const QString tempPath = temp->fileName();
-        temp->close();
-        const QStringList decodeArgs = {"-quiet", "-ppm", source, "-o", tempPath};
-        const auto decoded = runProcessWithCode(dwebp, decodeArgs);
-        if (decoded.first == -2) {
-            return {false, originalSize, originalSize, "dwebp", "执行超时"};
-        }
-        if (decoded.first != 0) {
-            QString msg = decoded.second.trimmed();
-            if (msg.isEmpty()) {
-                msg = "解码失败";
-            }
-            return {false, originalSize, originalSize, "dwebp", msg};
-        }
-        const int quality = options.lossless ? 100 : qBound(1, adjustQuality(options.quality, options.profile), 100);
-        const QStringList encodeArgs = {
-            "-quality",
-            QString::number(quality),
-            "-progressive",
-            "-optimize",
-            "-outfile",
-            output,
-            tempPath
-        };
-        const auto res = runProcessWithCode(cjpeg, encodeArgs);
+        QStringList decodeArgs = plan.dwebp.args;
+        decodeArgs << "-ppm" << source << "-o" << "-";
+        QStringList encodeArgs = plan.cjpeg.args;
+        encodeArgs << "-outfile" << output;
+        const QVector<ProcessCommand> commands = {{dwebp, decodeArgs}, {cjpeg, encodeArgs}};
+        const ProcessResult piped = co_await ProcessLauncher::startPipeline(commands, QByteArray(), kProcessTimeoutMs);
+        const auto res = qMakePair(piped.code, QString::fromUtf8(piped.output));
         const bool ok = res.first == 0;
         const qint64 outputSize = QFileInfo(output).size();
         if (res.first == -2) {
-            return {false, originalSize, outputSize, "dwebp+mozjpeg", "执行超时"};
+            co_return {false, originalSize, outputSize, "dwebp+mozjpeg", "执行超时"};
         }
         QString msg = ok ? "成功" : "失败";
         if (!ok) {
@@ -400,41 +627,73 @@ CompressionResult EngineRegistry::compressFile(
                 msg = tail;
             }
         }
-        return {ok, originalSize, outputSize, "dwebp+mozjpeg", msg};
+        co_return {ok, originalSize, outputSize, "dwebp+mozjpeg", msg};
     }
     if (suffix == "jpg") {
         if (options.lossless) {
-            const QString jpegtran = findTool({"jpegtran"});
-            if (jpegtran.isEmpty()) {
-                return missingEngine(source, "jpegtran");
+            if (JpegCodec::isAvailable()) {
+                QByteArray data;
+                if (readFileBytes(source, &data)) {
+                    QByteArray transcoded;
+                    QString error;
+                    if (JpegCodec::transcode(data, &transcoded, &error)) {
+                        if (transcoded.size() < data.size()) {
+                            if (writeFileBytes(output, transcoded)) {
+                                co_return {true, originalSize, transcoded.size(), "jpegtran(内置)", "成功"};
+                            }
+                        } else if (writeFileBytes(output, data)) {
+                            if (plan.windows) {
+                                const QString &jpegoptim = plan.jpegoptim.path;
+                                if (!jpegoptim.isEmpty()) {
+                                    QStringList optArgs = plan.jpegoptim.args;
+                                    optArgs << output;
+                                    const auto optRes = co_await runProcessWithCode(jpegoptim, optArgs);
+                                    if (optRes.first == 0) {
+                                        const qint64 newSize = QFileInfo(output).size();
+                                        if (newSize < originalSize) {
+                                            co_return {true, originalSize, newSize, "jpegoptim", "成功（Windows兜底）"};
+                                        }
+                                    }
+                                    writeFileBytes(output, data);
+                                }
+                            }
+                            const QString msg = transcoded == data ? "无损无收益（图像未变化）" : "已优化但无体积收益";
+                            co_return {true, originalSize, data.size(), "原图", msg};
+                        }
+                    } else if (isSameFormat(outputFormat, suffix) && isCorruptedInput(error)) {
+                        co_return keepOriginal(source, output, "源文件异常，已保留原图");
+                    }
+                }
             }
-            QStringList args = {"-copy", "none", "-optimize", "-progressive"};
-            if (detectPlatform() == "windows") {
-                args << "-trim";
+            const QString &jpegtran = plan.jpegtran.path;
+            if (jpegtran.isEmpty()) {
+                co_return missingEngine(source, "jpegtran");
             }
+            QStringList args = plan.jpegtran.args;
             args << "-outfile" << output << source;
-            const auto res = runProcessWithCode(jpegtran, args);
+            const auto res = co_await runProcessWithCode(jpegtran, args);
             const bool ok = res.first == 0;
             const qint64 outputSize = QFileInfo(output).size();
             if (res.first == -2) {
                 if (isSameFormat(outputFormat, suffix)) {
-                    return keepOriginal(source, output, "jpegtran 超时，已保留原图");
+                    co_return keepOriginal(source, output, "jpegtran 超时，已保留原图");
                 }
-                return {false, originalSize, outputSize, "jpegtran", "执行超时"};
+                co_return {false, originalSize, outputSize, "jpegtran", "执行超时"};
             }
             if (!ok && isSameFormat(outputFormat, suffix) && isCorruptedInput(res.second)) {
-                return keepOriginal(source, output, "源文件异常，已保留原图");
+                co_return keepOriginal(source, output, "源文件异常，已保留原图");
             }
             if (ok && outputSize >= originalSize) {
-                if (detectPlatform() == "windows") {
-                    const QString jpegoptim = findTool({"jpegoptim"});
+                if (plan.windows) {
+                    const QString &jpegoptim = plan.jpegoptim.path;
                     if (!jpegoptim.isEmpty()) {
-                        const QStringList optArgs = {"--strip-all", "--all-progressive", output};
-                        const auto optRes = runProcessWithCode(jpegoptim, optArgs);
+                        QStringList optArgs = plan.jpegoptim.args;
+                        optArgs << output;
+                        const auto optRes = co_await runProcessWithCode(jpegoptim, optArgs);
                         if (optRes.first == 0) {
                             const qint64 newSize = QFileInfo(output).size();
                             if (newSize < outputSize) {
-                                return {true, originalSize, newSize, "jpegoptim", "成功（Windows兜底）"};
+                                co_return {true, originalSize, newSize, "jpegoptim", "成功（Windows兜底）"};
                             }
                         }
                     }
@@ -465,170 +724,224 @@ CompressionResult EngineRegistry::compressFile(
                     if (!tail.isEmpty()) {
                         msg = QString("%1：%2").arg(msg, tail);
                     }
-                    return {true, originalSize, outputSize, "jpegtran", msg};
+                    co_return {true, originalSize, outputSize, "jpegtran", msg};
                 } else {
                     QString msg = "已优化但无体积收益";
                     if (!tail.isEmpty()) {
                         msg = QString("%1：%2").arg(msg, tail);
                     }
-                    return {true, originalSize, outputSize, "jpegtran", msg};
+                    co_return {true, originalSize, outputSize, "jpegtran", msg};
+                }
+            }
+            co_return {ok, originalSize, outputSize, "jpegtran", ok ? "成功" : "失败"};
+        }
+        const qint64 limit = outputLimit(source, output, suffix, options, originalSize);
+        if (JpegCodec::isAvailable()) {
+            QByteArray data;
+            if (readFileBytes(source, &data)) {
+                QByteArray encoded;
+                QString error;
+                const JpegCodec::Status status = JpegCodec::recompress(data, {plan.quality, true, true, true}, limit, &encoded, &error);
+                if (status == JpegCodec::Status::TooLarge) {
+                    co_return abortedEncode(source, output, nativeJpegEngine(), 0);
+                }
+                if (status == JpegCodec::Status::Success) {
+                    if (writeFileBytes(output, encoded)) {
+                        co_return {true, originalSize, encoded.size(), nativeJpegEngine(), "成功"};
+                    }
+                } else if (isSameFormat(outputFormat, suffix) && isCorruptedInput(error)) {
+                    co_return keepOriginal(source, output, "源文件异常，已保留原图");
                 }
             }
-            return {ok, originalSize, outputSize, "jpegtran", ok ? "成功" : "失败"};
         }
-        const QString cjpeg = findTool({"cjpeg", "mozjpeg"});
+        const QString &cjpeg = plan.cjpeg.path;
         if (cjpeg.isEmpty()) {
-            return missingEngine(source, "mozjpeg");
-        }
-        const int quality = qBound(1, adjustQuality(options.quality, options.profile), 100);
-        const QStringList args = {
-            "-quality",
-            QString::number(quality),
-            "-progressive",
-            "-optimize",
-            "-outfile",
-            output,
-            source
-        };
-        const auto res = runProcessWithCode(cjpeg, args);
+            co_return missingEngine(source, "mozjpeg");
+        }
+        QStringList args = plan.cjpeg.args;
+        if (limit <= 0) {
+            args << "-outfile" << output;
+        }
+        args << source;
+        const ProcessResult encoded = co_await runProcessCapped(cjpeg, args, output, limit, originalSize);
+        if (encoded.code == -3) {
+            co_return abortedEncode(source, output, "mozjpeg", savedCpuMs(cjpeg, encoded, originalSize));
+        }
+        const auto res = qMakePair(encoded.code, QString::fromUtf8(encoded.output));
         const bool ok = res.first == 0;
         const qint64 outputSize = QFileInfo(output).size();
         if (res.first == -2) {
             if (isSameFormat(outputFormat, suffix)) {
-                return keepOriginal(source, output, "mozjpeg 超时，已保留原图");
+                co_return keepOriginal(source, output, "mozjpeg 超时，已保留原图");
             }
-            return {false, originalSize, outputSize, "mozjpeg", "执行超时"};
+            co_return {false, originalSize, outputSize, "mozjpeg", "执行超时"};
         }
         if (!ok && isSameFormat(outputFormat, suffix) && isCorruptedInput(res.second)) {
-            return keepOriginal(source, output, "源文件异常，已保留原图");
+            co_return keepOriginal(source, output, "源文件异常，已保留原图");
         }
-        return {ok, originalSize, outputSize, "mozjpeg", ok ? "成功" : "失败"};
+        co_return {ok, originalSize, outputSize, "mozjpeg", ok ? "成功" : "失败"};
     }
     if (suffix == "png") {
         if (!options.lossless) {
-            const QString pngquant = findTool({"pngquant"});
+            if (PngQuantizer::isAvailable()) {
+                QImageReader reader(source, "png");
+                const QImage image = reader.read();
+                if (!image.isNull()) {
+                    QByteArray encoded;
+                    QString error;
+                    const auto status = PngQuantizer::quantize(
+                        image,
+                        {plan.pngquantMinQuality, plan.pngQuality, plan.pngquantSpeed},
+                        originalSize,
+                        &encoded,
+                        &error
+                    );
+                    if (status == PngQuantizer::Status::Success && writeFileBytes(output, encoded)) {
+                        co_return {true, originalSize, encoded.size(), "pngquant(内置)", "成功"};
+                    }
+                    if (status == PngQuantizer::Status::QualityTooLow || status == PngQuantizer::Status::NoGain) {
+                        QFile::remove(output);
+                        QFile::copy(source, output);
+                        const qint64 copiedSize = QFileInfo(output).size();
+                        co_return {true, originalSize, copiedSize, "原图", "pngquant 无收益，保留原图"};
+                    }
+                }
+            }
+            const QString &pngquant = plan.pngquant.path;
             if (!pngquant.isEmpty()) {
-                const int quality = qBound(10, adjustQuality(options.quality, options.profile), 100);
-                const auto settings = getPngquantSettings(options.profile, quality);
-                const QStringList args = {
-                    "--quality",
-                    QString("%1-%2").arg(settings.first).arg(quality),
-                    "--speed",
-                    QString::number(settings.second),
-                    "--strip",
-                    "--skip-if-larger",
-                    "--output", output,
-                    "--force",
-                    source
-                };
-                const auto res = runProcessWithCode(pngquant, args);
+                QStringList args = plan.pngquant.args;
+                args << "--output" << output << "--force" << source;
+                const auto res = co_await runProcessWithCode(pngquant, args);
                 const bool ok = res.first == 0;
                 const qint64 outputSize = QFileInfo(output).size();
                 if (res.first == -2) {
                     if (isSameFormat(outputFormat, suffix)) {
-                        return keepOriginal(source, output, "pngquant 超时，已保留原图");
+                        co_return keepOriginal(source, output, "pngquant 超时，已保留原图");
                     }
-                    return {false, originalSize, outputSize, "pngquant", "执行超时"};
+                    co_return {false, originalSize, outputSize, "pngquant", "执行超时"};
                 }
                 if (ok) {
-                    return {true, originalSize, outputSize, "pngquant", "成功"};
+                    co_return {true, originalSize, outputSize, "pngquant", "成功"};
                 }
                 if (res.first == 99) {
                     QFile::remove(output);
                     QFile::copy(source, output);
                     const qint64 copiedSize = QFileInfo(output).size();
-                    return {true, originalSize, copiedSize, "原图", "pngquant 无收益，保留原图"};
+                    co_return {true, originalSize, copiedSize, "原图", "pngquant 无收益，保留原图"};
                 }
                 if (isSameFormat(outputFormat, suffix) && isCorruptedInput(res.second)) {
-                    return keepOriginal(source, output, "源文件异常，已保留原图");
+                    co_return keepOriginal(source, output, "源文件异常，已保留原图");
                 }
             }
         }
         if (!options.lossless) {
-            return {false, originalSize, originalSize, "pngquant", "pngquant 无收益，已保留原图"};
+            co_return {false, originalSize, originalSize, "pngquant", "pngquant 无收益，已保留原图"};
+        }
+        if (PngOptimizer::isAvailable()) {
+            QByteArray data;
+            if (readFileBytes(source, &data)) {
+                QByteArray optimized;
+                QString error;
+                const CpuBudget::Lease lease(budget, budget ? budget->tokens() : 1);
+                if (PngOptimizer::optimize(data, pngOptimizeSettings(plan, lease.threads()), &optimized, &error)) {
+                    if (optimized.size() < data.size()) {
+                        if (writeFileBytes(output, optimized)) {
+                            co_return {true, originalSize, optimized.size(), "libpng(内置)", "成功"};
+                        }
+                    } else if (writeFileBytes(output, data)) {
+                        co_return {true, originalSize, data.size(), "原图", "已优化但无体积收益"};
+                    }
+                } else if (isSameFormat(outputFormat, suffix) && isCorruptedInput(error)) {
+                    co_return keepOriginal(source, output, "源文件异常，已保留原图");
+                }
+            }
         }
-        QString optimizer = findTool({"oxipng"});
+        QString optimizer = plan.oxipng.path;
         QStringList args;
-        const QString normalized = normalizeProfile(options.profile);
         if (!optimizer.isEmpty()) {
-                const QString level = normalized == "strong" ? "3" : (normalized == "balanced" ? "2" : "1");
-                if (source == output) {
-                    args = {"-o", level, "--strip", "safe", source};
-                } else {
-                    args = {"-o", level, "--strip", "safe", "--out", output, source};
-                }
-            const auto res = runProcessWithCode(optimizer, args);
+            const CpuBudget::Lease lease(budget, budget ? budget->tokens() : 1);
+            args = plan.oxipng.args;
+            args << threadArgs("oxipng", lease.threads());
+            if (source != output) {
+                args << "--out" << output;
+            }
+            args << source;
+            const auto res = co_await runProcessWithCode(optimizer, args);
             const bool ok = res.first == 0;
             const qint64 outputSize = QFileInfo(output).size();
             if (res.first == -2) {
                 if (isSameFormat(outputFormat, suffix)) {
-                    return keepOriginal(source, output, "oxipng 超时，已保留原图");
+                    co_return keepOriginal(source, output, "oxipng 超时，已保留原图");
                 }
-                return {false, originalSize, outputSize, "oxipng", "执行超时"};
+                co_return {false, originalSize, outputSize, "oxipng", "执行超时"};
             }
             if (!ok && isSameFormat(outputFormat, suffix) && isCorruptedInput(res.second)) {
-                return keepOriginal(source, output, "源文件异常，已保留原图");
+                co_return keepOriginal(source, output, "源文件异常，已保留原图");
             }
             if (ok) {
-                return {true, originalSize, outputSize, "oxipng", "成功"};
+                co_return {true, originalSize, outputSize, "oxipng", "成功"};
             }
         }
-        if (detectPlatform() == "windows") {
-            optimizer = findTool({"optipng"});
+        if (plan.windows) {
+            optimizer = plan.optipng.path;
             if (!optimizer.isEmpty()) {
-                    if (source == output) {
-                        args = {"-o7", "-strip", "all", source};
-                    } else {
-                        args = {"-o7", "-strip", "all", "-out", output, source};
-                    }
-                const auto res = runProcessWithCode(optimizer, args);
+                args = plan.optipng.args;
+                if (source != output) {
+                    args << "-out" << output;
+                }
+                args << source;
+                const auto res = co_await runProcessWithCode(optimizer, args);
                 const bool ok = res.first == 0;
                 const qint64 outputSize = QFileInfo(output).size();
                 if (res.first == -2) {
                     if (isSameFormat(outputFormat, suffix)) {
-                        return keepOriginal(source, output, "optipng 超时，已保留原图");
+                        co_return keepOriginal(source, output, "optipng 超时，已保留原图");
                     }
-                    return {false, originalSize, outputSize, "optipng", "执行超时"};
+                    co_return {false, originalSize, outputSize, "optipng", "执行超时"};
                 }
                 if (!ok && isSameFormat(outputFormat, suffix) && isCorruptedInput(res.second)) {
-                    return keepOriginal(source, output, "源文件异常，已保留原图");
+                    co_return keepOriginal(source, output, "源文件异常，已保留原图");
                 }
-                return {ok, originalSize, outputSize, "optipng", ok ? "成功" : "失败"};
+                co_return {ok, originalSize, outputSize, "optipng", ok ? "成功" : "失败"};
             }
         }
-        return missingEngine(source, "oxipng/optipng");
+        co_return missingEngine(source, "oxipng/optipng");
     }
     if (suffix == "gif") {
-        const QString gifsicle = findTool({"gifsicle"});
+        const QString &gifsicle = plan.gifsicle.path;
         if (gifsicle.isEmpty()) {
-            return missingEngine(source, "gifsicle");
+            co_return missingEngine(source, "gifsicle");
         }
-        const QStringList baseArgs = {"-O3", "--no-comments", "--no-names", "--no-extensions"};
+        const QStringList &baseArgs = plan.gifsicle.args;
         QStringList args = baseArgs;
         const bool useLossy = !options.lossless;
-        int lossy = 0;
-        int colors = 0;
+        const int lossy = plan.gifLossy;
+        const int colors = plan.gifColors;
         if (useLossy) {
-            const int quality = qBound(1, adjustQuality(options.quality, options.profile), 100);
-            lossy = qMax(0, static_cast<int>((100 - quality) * 2));
-            lossy = adjustLossy(options.profile, lossy);
-            colors = qMax(32, static_cast<int>(256 * quality / 100));
-            colors = adjustColors(options.profile, colors);
-            args << QString("--lossy=%1").arg(lossy) << QString("--colors=%1").arg(colors);
-        }
-        args << source << "-o" << output;
-        auto res = runProcessWithOutput(gifsicle, args);
+            args << gifsicleLossyArgs(lossy, colors);
+        }
+        const qint64 limit = outputLimit(source, output, suffix, options, originalSize);
+        args << source;
+        if (limit <= 0) {
+            args << "-o" << output;
+        }
+        ProcessResult encoded = co_await runProcessCapped(gifsicle, args, output, limit, originalSize);
+        bool overLimit = encoded.code == -3;
+        if (overLimit && !useLossy) {
+            co_return abortedEncode(source, output, "gifsicle", savedCpuMs(gifsicle, encoded, originalSize));
+        }
+        auto res = qMakePair(encoded.code == 0, QString::fromUtf8(encoded.output));
         bool ok = res.first;
         bool usedLossy = useLossy;
-        if (!ok && useLossy) {
+        if (!ok && useLossy && !overLimit) {
             QStringList retryArgs = baseArgs;
             retryArgs << source << "-o" << output;
-            res = runProcessWithOutput(gifsicle, retryArgs);
+            res = co_await runProcessWithOutput(gifsicle, retryArgs);
             ok = res.first;
             usedLossy = false;
         }
-        qint64 outputSize = QFileInfo(output).size();
-        if (ok && usedLossy && outputSize >= originalSize) {
+        qint64 outputSize = overLimit ? originalSize : QFileInfo(output).size();
+        if (usedLossy && (overLimit || (ok && outputSize >= originalSize))) {
             const int retryLossy = qMin(200, static_cast<int>(lossy * 1.3) + 5);
             const int retryColors = qMax(32, static_cast<int>(colors * 0.8));
             QScopedPointer<QTemporaryFile> temp(new QTemporaryFile(QDir(QFileInfo(output).absolutePath()).filePath(".imgcompress_gif_XXXXXX.gif")));
@@ -643,23 +956,31 @@ CompressionResult EngineRegistry::compressFile(
                 const QString tempPath = temp->fileName();
                 temp->close();
                 QStringList retryArgs = baseArgs;
-                retryArgs << QString("--lossy=%1").arg(retryLossy) << QString("--colors=%1").arg(retryColors);
-                retryArgs << source << "-o" << tempPath;
-                const auto retryRes = runProcessWithOutput(gifsicle, retryArgs);
-                if (retryRes.first) {
+                retryArgs << gifsicleLossyArgs(retryLossy, retryColors);
+                retryArgs << source;
+                if (limit <= 0) {
+                    retryArgs << "-o" << tempPath;
+                }
+                const ProcessResult retried = co_await runProcessCapped(gifsicle, retryArgs, tempPath, limit, originalSize);
+                encoded.cpuMs += retried.cpuMs;
+                if (retried.code == 0) {
                     const qint64 retrySize = QFileInfo(tempPath).size();
-                    if (retrySize > 0 && retrySize < outputSize) {
+                    if (retrySize > 0 && (overLimit || retrySize < outputSize)) {
                         QFile::remove(output);
                         QFile::copy(tempPath, output);
                         outputSize = retrySize;
-                        res = retryRes;
+                        res = qMakePair(true, QString::fromUtf8(retried.output));
                         ok = true;
+                        overLimit = false;
                     }
                 }
             }
         }
+        if (overLimit) {
+            co_return abortedEncode(source, output, "gifsicle", savedCpuMs(gifsicle, encoded, originalSize));
+        }
         if (!ok && isSameFormat(outputFormat, suffix) && isCorruptedInput(res.second)) {
-            return keepOriginal(source, output, "源文件异常，已保留原图");
+            co_return keepOriginal(source, output, "源文件异常，已保留原图");
         }
         QString msg = ok ? "成功" : "失败";
         if (!ok) {
@@ -668,21 +989,37 @@ CompressionResult EngineRegistry::compressFile(
                 msg = tail;
             }
         }
-        return {ok, originalSize, outputSize, "gifsicle", msg};
+        co_return {ok, originalSize, outputSize, "gifsicle", msg};
     }
     if (suffix == "webp") {
-        const QString cwebp = findTool({"cwebp"});
+        const qint64 limit = outputLimit(source, output, suffix, options, originalSize);
+        if (WebpCodec::isAvailable()) {
+            const CpuBudget::Lease lease(budget, kWebpThreads);
+            QImage image;
+            QString error;
+            QByteArray encoded;
+            if (decodeWebpFile(source, &image, &error)) {
+                const WebpCodec::Status status = WebpCodec::encode(image, webpSettings(plan, lease.threads()), limit, &encoded, &error);
+                if (status == WebpCodec::Status::TooLarge) {
+                    co_return abortedEncode(source, output, "libwebp(内置)", 0);
+                }
+                if (status == WebpCodec::Status::Success && writeFileBytes(output, encoded)) {
+                    co_return {true, originalSize, encoded.size(), "libwebp(内置)", "成功"};
+                }
+            }
+        }
+        const QString &cwebp = plan.cwebp.path;
         if (cwebp.isEmpty()) {
-            return missingEngine(source, "cwebp");
+            co_return missingEngine(source, "cwebp");
         }
-        QStringList args;
-        if (options.lossless) {
-            args = {"-lossless", "-z", "9", "-m", "5", "-metadata", "none", source, "-o", output};
-        } else {
-            const int quality = qBound(1, adjustQuality(options.quality, options.profile), 100);
-            args = {"-q", QString::number(quality), "-m", "5", "-metadata", "none", source, "-o", output};
+        const CpuBudget::Lease lease(budget, kWebpThreads);
+        QStringList args = plan.cwebp.args;
+        args << threadArgs("cwebp", lease.threads()) << source << "-o" << (limit > 0 ? QString("-") : output);
+        const ProcessResult encoded = co_await runProcessCapped(cwebp, args, output, limit, originalSize);
+        if (encoded.code == -3) {
+            co_return abortedEncode(source, output, "cwebp", savedCpuMs(cwebp, encoded, originalSize));
         }
-        const auto res = runProcessWithCode(cwebp, args);
+        const auto res = qMakePair(encoded.code, QString::fromUtf8(encoded.output));
         const bool ok = res.first == 0;
         const qint64 outputSize = QFileInfo(output).size();
         if (!ok) {
@@ -690,18 +1027,169 @@ CompressionResult EngineRegistry::compressFile(
             const bool noOutput = !QFileInfo::exists(output);
             if (res.first == -2) {
                 if (isSameFormat(outputFormat, suffix)) {
-                    return keepOriginal(source, output, "cwebp 超时，已保留原图");
+                    co_return keepOriginal(source, output, "cwebp 超时，已保留原图");
                 }
-                return {false, originalSize, outputSize, "cwebp", "执行超时"};
+                co_return {false, originalSize, outputSize, "cwebp", "执行超时"};
             }
             if (isSameFormat(outputFormat, suffix) && (isCorruptedInput(tail) || noOutput)) {
                 const QString msg = tail.isEmpty() ? "cwebp 失败，已保留原图" : QString("cwebp 失败，已保留原图：%1").arg(tail);
-                return keepOriginal(source, output, msg);
+                co_return keepOriginal(source, output, msg);
             }
             const QString msg = tail.isEmpty() ? "失败" : tail;
-            return {false, originalSize, outputSize, "cwebp", msg};
+            co_return {false, originalSize, outputSize, "cwebp", msg};
+        }
+        co_return {true, originalSize, outputSize, "cwebp", "成功"};
+    }
+    co_return {false, originalSize, originalSize, "无", "不支持的格式"};
+}
+
+Task<CompressionResult> EngineRegistry::compressImage(
+    const QImage &image,
+    const QString &output,
+    const QString &format,
+    const CompressionPlan &plan,
+    qint64 originalSize,
+    CpuBudget *budget
+) {
+    const bool streamable = format == "jpg" || format == "webp";
+    const bool nativeEncoder = (format == "jpg" && JpegCodec::isAvailable())
+        || (format == "webp" && WebpCodec::isAvailable());
+    if (streamable && !nativeEncoder) {
+        const ToolPlan &tool = format == "jpg" ? plan.cjpeg : plan.cwebp;
+        if (!tool.path.isEmpty()) {
+            const CpuBudget::Lease lease(budget, format == "webp" ? kWebpThreads : 1);
+            QStringList args = tool.args;
+            if (format == "jpg") {
+                args << "-outfile" << output;
+            } else {
+                args << threadArgs("cwebp", lease.threads()) << "-o" << output << "--" << "-";
+            }
+            const QVector<ProcessCommand> commands = {{tool.path, args}};
+            const ProcessResult res = co_await ProcessLauncher::startPipeline(
+                commands,
+                pnmBytes(image, format == "webp"),
+                kProcessTimeoutMs
+            );
+            if (res.code == 0) {
+                const QString engine = format == "jpg" ? "mozjpeg" : "cwebp";
+                co_return {true, originalSize, QFileInfo(output).size(), engine, "成功"};
+            }
+        }
+    }
+    QByteArray encoded;
+    QString error;
+    if (!encodeImageBytes(image, format, plan.encodeQuality, plan.options.lossless, budget, &encoded, &error)
+        || !writeFileBytes(output, encoded)) {
+        co_return {false, originalSize, originalSize, "Qt", error.isEmpty() ? QString("无法写入格式") : error};
+    }
+    if (streamable) {
+        if (!nativeEncoder) {
+            co_return {true, originalSize, encoded.size(), "Qt", "已转换"};
+        }
+        const QString engine = format == "jpg" ? nativeJpegEngine() : QString("libwebp(内置)");
+        co_return {true, originalSize, encoded.size(), engine, "成功"};
+    }
+    CompressionResult result = co_await compressFile(output, output, plan, ImageProbe::probeBytes(encoded), budget);
+    result.originalSize = originalSize;
+    result.outputSize = QFileInfo(output).size();
+    co_return result;
+}
+
+bool EngineRegistry::canBatch(const QString &suffix, const CompressionPlan &plan) {
+    return !batchTool(suffix, plan).isEmpty();
+}
+
+Task<QVector<CompressionResult>> EngineRegistry::compressBatch(
+    const QStringList &sources,
+    const QStringList &outputs,
+    const CompressionPlan &plan,
+    const QVector<ImageInfo> &infos,
+    CpuBudget *budget
+) {
+    if (!OutputCache::isEnabled() || sources.size() != outputs.size() || sources.size() != infos.size()) {
+        const QVector<CompressionResult> compressed = co_await compressBatchWithEngines(sources, outputs, plan, infos, budget);
+        co_return compressed;
+    }
+    QVector<CompressionResult> results(sources.size());
+    QStringList keys;
+    QStringList pendingSources;
+    QStringList pendingOutputs;
+    QVector<ImageInfo> pendingInfos;
+    QVector<int> pending;
+    for (int i = 0; i < sources.size(); i += 1) {
+        keys.append(cacheKeyFor(sources[i], infos[i], plan.options));
+        if (!restoreCached(keys[i], infos[i].size, outputs[i], &results[i])) {
+            pending.append(i);
+            pendingSources.append(sources[i]);
+            pendingOutputs.append(outputs[i]);
+            pendingInfos.append(infos[i]);
+        }
+    }
+    if (pending.isEmpty()) {
+        co_return results;
+    }
+    const QVector<CompressionResult> compressed = co_await compressBatchWithEngines(pendingSources, pendingOutputs, plan, pendingInfos, budget);
+    for (int i = 0; i < pending.size() && i < compressed.size(); i += 1) {
+        results[pending[i]] = compressed[i];
+        storeCached(keys[pending[i]], outputs[pending[i]], compressed[i]);
+    }
+    co_return results;
+}
+
+Task<QVector<CompressionResult>> EngineRegistry::compressBatchWithEngines(
+    const QStringList &sources,
+    const QStringList &outputs,
+    const CompressionPlan &plan,
+    const QVector<ImageInfo> &infos,
+    CpuBudget *budget
+) {
+    QVector<CompressionResult> results;
+    results.reserve(sources.size());
+    const QString probed = normalizeSuffix(infos.value(0).format);
+    const QString suffix = probed.isEmpty() ? normalizeSuffix(QFileInfo(sources.value(0)).suffix().toLower()) : probed;
+    const QString program = batchTool(suffix, plan);
+    QVector<qint64> originalSizes;
+    bool prepared = !program.isEmpty() && sources.size() == outputs.size() && sources.size() == infos.size();
+    for (int i = 0; prepared && i < sources.size(); i += 1) {
+        const QFileInfo sourceInfo(sources[i]);
+        if (sourceInfo.absoluteFilePath() == QFileInfo(outputs[i]).absoluteFilePath()) {
+            prepared = false;
+            break;
+        }
+        originalSizes.append(infos[i].size);
+        QFile::remove(outputs[i]);
+        prepared = QFile::copy(sources[i], outputs[i]);
+    }
+    int code = -1;
+    if (prepared) {
+        const int timeoutMs = kProcessTimeoutMs + static_cast<int>(sources.size()) * kBatchFileTimeoutMs;
+        const bool parallel = suffix == "png" && plan.options.lossless;
+        const CpuBudget::Lease lease(budget, parallel ? static_cast<int>(sources.size()) : 1);
+        const QStringList args = batchArgs(suffix, plan, outputs, lease.threads());
+        const ProcessResult batched = co_await ProcessLauncher::start(program, args, timeoutMs);
+        code = batched.code;
+    }
+    const bool pngquant = suffix == "png" && !plan.options.lossless;
+    const bool accepted = prepared && (code == 0 || (pngquant && (code == 98 || code == 99)));
+    if (!accepted) {
+        for (int i = 0; i < sources.size(); i += 1) {
+            const ImageInfo info = i < infos.size() ? infos[i] : ImageProbe::probe(sources[i]);
+            const CompressionResult result = co_await compressWithEngines(sources[i], outputs.value(i), plan, info, budget);
+            results.append(result);
+        }
+        co_return results;
+    }
+    const QString engine = suffix == "gif" ? "gifsicle" : (pngquant ? "pngquant" : "oxipng");
+    for (int i = 0; i < sources.size(); i += 1) {
+        const qint64 outputSize = QFileInfo(outputs[i]).size();
+        if (outputSize > 0 && outputSize < originalSizes[i]) {
+            results.append({true, originalSizes[i], outputSize, engine, "成功"});
+        } else if (suffix == "gif" && !plan.options.lossless) {
+            const CompressionResult result = co_await compressWithEngines(sources[i], outputs[i], plan, infos[i], budget);
+            results.append(result);
+        } else {
+            results.append(keepOriginal(sources[i], outputs[i], pngquant ? "pngquant 无收益，保留原图" : "已保留原图"));
         }
-        return {true, originalSize, outputSize, "cwebp", "成功"};
     }
-    return {false, originalSize, originalSize, "无", "不支持的格式"};
+    co_return results;
 }
@@ -1,8 +1,16 @@
 #pragma once
 
+#include "ImageProbe.h"
+#include "Task.h"
+
 #include <QtGlobal>
 #include <QString>
 #include <QStringList>
+#include <QVector>
+
+class CpuBudget;
+class QImage;
+struct CompressionPlan;
 
 struct CompressionOptions {
     bool lossless;
@@ -14,6 +22,8 @@ struct CompressionOptions {
     int targetWidth;
     int targetHeight;
     int resizeMode;
+    int batchSize;
+    int abortPercent;
 };
 
 struct CompressionResult {
@@ -22,6 +32,8 @@ struct CompressionResult {
     qint64 outputSize;
     QString engine;
     QString message;
+    bool aborted;
+    qint64 cpuSavedMs;
 };
 
 class EngineRegistry {
@@ -29,9 +41,51 @@ public:
     static QStringList availableEngines();
     static bool toolExists(const QString &name);
     static QString engineStatus(bool lossless);
-    static CompressionResult compressFile(
+    static QString engineSignature();
+    static QString preferredEngine(const CompressionPlan &plan, const QString &source, const QString &target);
+    static quint64 optionsFingerprint(const CompressionOptions &options);
+    static bool canEncodeWebp();
+    static bool canDecodeWebp();
+    static bool canResizeWebp();
+    static QImage readImage(const QString &path, const QString &format);
+    static bool writeImage(const QImage &image, const QString &path, const QString &format, int quality);
+    static Task<CompressionResult> compressFile(
+        const QString &source,
+        const QString &output,
+        const CompressionPlan &plan,
+        const ImageInfo &info,
+        CpuBudget *budget
+    );
+    static Task<CompressionResult> compressImage(
+        const QImage &image,
+        const QString &output,
+        const QString &format,
+        const CompressionPlan &plan,
+        qint64 originalSize,
+        CpuBudget *budget
+    );
+    static bool canBatch(const QString &suffix, const CompressionPlan &plan);
+    static Task<QVector<CompressionResult>> compressBatch(
+        const QStringList &sources,
+        const QStringList &outputs,
+        const CompressionPlan &plan,
+        const QVector<ImageInfo> &infos,
+        CpuBudget *budget
+    );
+
+private:
+    static Task<CompressionResult> compressWithEngines(
         const QString &source,
         const QString &output,
-        const CompressionOptions &options
+        const CompressionPlan &plan,
+        const ImageInfo &info,
+        CpuBudget *budget
+    );
+    static Task<QVector<CompressionResult>> compressBatchWithEngines(
+        const QStringList &sources,
+        const QStringList &outputs,
+        const CompressionPlan &plan,
+        const QVector<ImageInfo> &infos,
+        CpuBudget *budget
     );
 };
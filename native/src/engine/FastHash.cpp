@@ -0,0 +1,106 @@
+#include "FastHash.h"
+
+#include <QFile>
+#include <QtEndian>
+
+namespace {
+const quint64 kPrime1 = 11400714785074694791ULL;
+const quint64 kPrime2 = 14029467366897019727ULL;
+const quint64 kPrime3 = 1609587929392839161ULL;
+const quint64 kPrime4 = 9650029242287828579ULL;
+const quint64 kPrime5 = 2870177450012600261ULL;
+
+quint64 rotateLeft(quint64 value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+quint64 read64(const uchar *data) {
+    return qFromLittleEndian<quint64>(data);
+}
+
+quint64 read32(const uchar *data) {
+    return qFromLittleEndian<quint32>(data);
+}
+
+quint64 round(quint64 accumulator, quint64 input) {
+    accumulator += input * kPrime2;
+    accumulator = rotateLeft(accumulator, 31);
+    return accumulator * kPrime1;
+}
+
+quint64 mergeRound(quint64 accumulator, quint64 value) {
+    accumulator ^= round(0, value);
+    return accumulator * kPrime1 + kPrime4;
+}
+}
+
+quint64 FastHash::hash(const char *data, qsizetype size, quint64 seed) {
+    const uchar *cursor = reinterpret_cast<const uchar *>(data);
+    const uchar *end = cursor + size;
+    quint64 result = 0;
+    if (size >= 32) {
+        quint64 v1 = seed + kPrime1 + kPrime2;
+        quint64 v2 = seed + kPrime2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - kPrime1;
+        const uchar *limit = end - 32;
+        do {
+            v1 = round(v1, read64(cursor));
+            v2 = round(v2, read64(cursor + 8));
+            v3 = round(v3, read64(cursor + 16));
+            v4 = round(v4, read64(cursor + 24));
+            cursor += 32;
+        } while (cursor <= limit);
+        result = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        result = mergeRound(result, v1);
+        result = mergeRound(result, v2);
+        result = mergeRound(result, v3);
+        result = mergeRound(result, v4);
+    } else {
+        result = seed + kPrime5;
+    }
+    result += static_cast<quint64>(size);
+    while (end - cursor >= 8) {
+        result ^= round(0, read64(cursor));
+        result = rotateLeft(result, 27) * kPrime1 + kPrime4;
+        cursor += 8;
+    }
+    if (end - cursor >= 4) {
+        result ^= read32(cursor) * kPrime1;
+        result = rotateLeft(result, 23) * kPrime2 + kPrime3;
+        cursor += 4;
+    }
+    while (cursor < end) {
+        result ^= *cursor * kPrime5;
+        result = rotateLeft(result, 11) * kPrime1;
+        cursor += 1;
+    }
+    result ^= result >> 33;
+    result *= kPrime2;
+    result ^= result >> 29;
+    result *= kPrime3;
+    result ^= result >> 32;
+    return result;
+}
+
+quint64 FastHash::hashFile(const QString &path, bool *ok) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *ok = false;
+        return 0;
+    }
+    const qint64 size = file.size();
+    if (size == 0) {
+        *ok = true;
+        return hash(nullptr, 0);
+    }
+    if (uchar *mapped = file.map(0, size)) {
+        const quint64 value = hash(reinterpret_cast<const char *>(mapped), size);
+        file.unmap(mapped);
+        *ok = true;
+        return value;
+    }
+    const QByteArray data = file.readAll();
+    *ok = data.size() == size;
+    return hash(data.constData(), data.size());
+}
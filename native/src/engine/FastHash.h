@@ -0,0 +1,10 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+class FastHash {
+public:
+    static quint64 hash(const char *data, qsizetype size, quint64 seed = 0);
+    static quint64 hashFile(const QString &path, bool *ok);
+};
@@ -0,0 +1,249 @@
+#include "ImageProbe.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+const qint64 kHeadBytes = 4096;
+const qint64 kMaxProbeBytes = 1024 * 1024;
+
+class HeaderBuffer {
+public:
+    HeaderBuffer(QFile *source, const QByteArray &initial) : file(source), data(initial) {}
+
+    bool ensure(qint64 end) {
+        if (end <= data.size()) {
+            return true;
+        }
+        if (!file || end > kMaxProbeBytes) {
+            return false;
+        }
+        const qint64 wanted = qMin(kMaxProbeBytes, qMax(end, data.size() + kHeadBytes)) - data.size();
+        const QByteArray more = file->read(wanted);
+        if (more.isEmpty()) {
+            file = nullptr;
+            return false;
+        }
+        data.append(more);
+        return end <= data.size();
+    }
+
+    bool matches(qint64 offset, const char *magic, qint64 length) {
+        return ensure(offset + length) && memcmp(data.constData() + offset, magic, length) == 0;
+    }
+
+    uchar at(qint64 offset) const {
+        return static_cast<uchar>(data.at(offset));
+    }
+
+    quint16 be16(qint64 offset) const {
+        return qFromBigEndian<quint16>(bytes(offset));
+    }
+
+    quint32 be32(qint64 offset) const {
+        return qFromBigEndian<quint32>(bytes(offset));
+    }
+
+    quint16 le16(qint64 offset) const {
+        return qFromLittleEndian<quint16>(bytes(offset));
+    }
+
+    quint32 le24(qint64 offset) const {
+        return at(offset) | (at(offset + 1) << 8) | (at(offset + 2) << 16);
+    }
+
+    quint32 le32(qint64 offset) const {
+        return qFromLittleEndian<quint32>(bytes(offset));
+    }
+
+private:
+    const uchar *bytes(qint64 offset) const {
+        return reinterpret_cast<const uchar *>(data.constData() + offset);
+    }
+
+    QFile *file;
+    QByteArray data;
+};
+
+QString normalizeFormat(const QByteArray &format) {
+    const QString lower = QString::fromLatin1(format).toLower();
+    return lower == "jpeg" ? QString("jpg") : lower;
+}
+
+void parseJpeg(HeaderBuffer &buffer, ImageInfo *info) {
+    qint64 pos = 2;
+    while (buffer.ensure(pos + 4)) {
+        if (buffer.at(pos) != 0xFF) {
+            return;
+        }
+        const uchar marker = buffer.at(pos + 1);
+        if (marker == 0xFF) {
+            pos += 1;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+            pos += 2;
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) {
+            return;
+        }
+        const int length = buffer.be16(pos + 2);
+        if (length < 2) {
+            return;
+        }
+        const bool frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (frame) {
+            if (buffer.ensure(pos + 9)) {
+                info->bitDepth = buffer.at(pos + 4);
+                info->height = buffer.be16(pos + 5);
+                info->width = buffer.be16(pos + 7);
+            }
+            return;
+        }
+        pos += 2 + length;
+    }
+}
+
+void parsePng(HeaderBuffer &buffer, ImageInfo *info) {
+    if (!buffer.matches(12, "IHDR", 4) || !buffer.ensure(33)) {
+        return;
+    }
+    info->width = static_cast<int>(buffer.be32(16));
+    info->height = static_cast<int>(buffer.be32(20));
+    info->bitDepth = buffer.at(24);
+    const uchar colorType = buffer.at(25);
+    info->hasAlpha = colorType == 4 || colorType == 6;
+    qint64 pos = 33;
+    while (buffer.ensure(pos + 8)) {
+        if (buffer.matches(pos + 4, "IDAT", 4) || buffer.matches(pos + 4, "IEND", 4)) {
+            return;
+        }
+        if (buffer.matches(pos + 4, "tRNS", 4)) {
+            info->hasAlpha = true;
+        } else if (buffer.matches(pos + 4, "acTL", 4)) {
+            info->animated = true;
+        }
+        pos += 12 + static_cast<qint64>(buffer.be32(pos));
+    }
+}
+
+qint64 skipSubBlocks(HeaderBuffer &buffer, qint64 pos) {
+    while (buffer.ensure(pos + 1)) {
+        const int length = buffer.at(pos);
+        pos += 1 + length;
+        if (length == 0) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+void parseGif(HeaderBuffer &buffer, ImageInfo *info) {
+    if (!buffer.ensure(13)) {
+        return;
+    }
+    info->width = buffer.le16(6);
+    info->height = buffer.le16(8);
+    const uchar packed = buffer.at(10);
+    info->bitDepth = (packed & 0x07) + 1;
+    qint64 pos = 13;
+    if (packed & 0x80) {
+        pos += 3 * (1 << ((packed & 0x07) + 1));
+    }
+    int frames = 0;
+    while (pos >= 0 && buffer.ensure(pos + 2)) {
+        const uchar block = buffer.at(pos);
+        if (block == 0x21) {
+            const uchar label = buffer.at(pos + 1);
+            if (label == 0xF9 && buffer.ensure(pos + 4) && (buffer.at(pos + 3) & 0x01)) {
+                info->hasAlpha = true;
+            } else if (label == 0xFF && buffer.matches(pos + 3, "NETSCAPE2.0", 11)) {
+                info->animated = true;
+            }
+            pos = skipSubBlocks(buffer, pos + 2);
+        } else if (block == 0x2C) {
+            frames += 1;
+            if (frames > 1) {
+                info->animated = true;
+                return;
+            }
+            if (!buffer.ensure(pos + 10)) {
+                return;
+            }
+            const uchar imagePacked = buffer.at(pos + 9);
+            pos += 10;
+            if (imagePacked & 0x80) {
+                pos += 3 * (1 << ((imagePacked & 0x07) + 1));
+            }
+            pos = skipSubBlocks(buffer, pos + 1);
+        } else {
+            return;
+        }
+    }
+}
+
+void parseWebp(HeaderBuffer &buffer, ImageInfo *info) {
+    info->bitDepth = 8;
+    if (buffer.matches(12, "VP8 ", 4)) {
+        if (buffer.ensure(30) && buffer.at(23) == 0x9D && buffer.at(24) == 0x01 && buffer.at(25) == 0x2A) {
+            info->width = buffer.le16(26) & 0x3FFF;
+            info->height = buffer.le16(28) & 0x3FFF;
+        }
+    } else if (buffer.matches(12, "VP8L", 4)) {
+        if (buffer.ensure(25) && buffer.at(20) == 0x2F) {
+            const quint32 bits = buffer.le32(21);
+            info->width = static_cast<int>(bits & 0x3FFF) + 1;
+            info->height = static_cast<int>((bits >> 14) & 0x3FFF) + 1;
+            info->hasAlpha = (bits >> 28) & 0x01;
+        }
+    } else if (buffer.matches(12, "VP8X", 4)) {
+        if (buffer.ensure(30)) {
+            const uchar flags = buffer.at(20);
+            info->hasAlpha = flags & 0x10;
+            info->animated = flags & 0x02;
+            info->width = static_cast<int>(buffer.le24(24)) + 1;
+            info->height = static_cast<int>(buffer.le24(27)) + 1;
+        }
+    }
+}
+
+ImageInfo parseHeader(HeaderBuffer &buffer, qint64 size) {
+    ImageInfo info{QString(), 0, 0, 0, false, false, size, 0, false};
+    if (buffer.matches(0, "\xFF\xD8\xFF", 3)) {
+        info.format = "jpg";
+        parseJpeg(buffer, &info);
+    } else if (buffer.matches(0, "\x89PNG\r\n\x1A\n", 8)) {
+        info.format = "png";
+        parsePng(buffer, &info);
+    } else if (buffer.matches(0, "GIF87a", 6) || buffer.matches(0, "GIF89a", 6)) {
+        info.format = "gif";
+        parseGif(buffer, &info);
+    } else if (buffer.matches(0, "RIFF", 4) && buffer.matches(8, "WEBP", 4)) {
+        info.format = "webp";
+        parseWebp(buffer, &info);
+    }
+    return info;
+}
+}
+
+ImageInfo ImageProbe::probe(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {QString(), 0, 0, 0, false, false, QFileInfo(path).size(), 0, false};
+    }
+    HeaderBuffer buffer(&file, file.read(kHeadBytes));
+    ImageInfo info = parseHeader(buffer, file.size());
+    if (info.format.isEmpty() && file.seek(0)) {
+        info.format = normalizeFormat(QImageReader::imageFormat(&file));
+    }
+    return info;
+}
+
+ImageInfo ImageProbe::probeBytes(const QByteArray &data) {
+    HeaderBuffer buffer(nullptr, data);
+    return parseHeader(buffer, data.size());
+}
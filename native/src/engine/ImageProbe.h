@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+struct ImageInfo {
+    QString format;
+    int width;
+    int height;
+    int bitDepth;
+    bool hasAlpha;
+    bool animated;
+    qint64 size;
+    quint64 contentHash;
+    bool hashed;
+};
+
+class ImageProbe {
+public:
+    static ImageInfo probe(const QString &path);
+    static ImageInfo probeBytes(const QByteArray &data);
+};
@@ -0,0 +1,378 @@
+#include "JpegCodec.h"
+
+#include <QImage>
+
+#if defined(IMGCOMPRESS_HAS_LIBJPEG)
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+#endif
+
+namespace {
+#if defined(IMGCOMPRESS_HAS_LIBJPEG)
+const int kDestinationChunk = 64 * 1024;
+
+struct ErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+    int warnings;
+    bool exceeded;
+};
+
+struct BufferDestination {
+    jpeg_destination_mgr pub;
+    QByteArray *buffer;
+    qint64 limit;
+};
+
+void onError(j_common_ptr info) {
+    auto *manager = reinterpret_cast<ErrorManager *>(info->err);
+    (*info->err->format_message)(info, manager->message);
+    longjmp(manager->jump, 1);
+}
+
+void onMessage(j_common_ptr info, int level) {
+    if (level >= 0) {
+        return;
+    }
+    auto *manager = reinterpret_cast<ErrorManager *>(info->err);
+    if (manager->warnings == 0) {
+        (*info->err->format_message)(info, manager->message);
+    }
+    manager->warnings += 1;
+}
+
+void initErrorManager(ErrorManager *manager) {
+    jpeg_std_error(&manager->base);
+    manager->base.error_exit = onError;
+    manager->base.emit_message = onMessage;
+    manager->message[0] = '\0';
+    manager->warnings = 0;
+    manager->exceeded = false;
+}
+
+qsizetype cappedSize(const BufferDestination *dest, qsizetype wanted) {
+    return dest->limit > 0 ? static_cast<qsizetype>(qMin<qint64>(wanted, dest->limit + 1)) : wanted;
+}
+
+void initDestination(j_compress_ptr info) {
+    auto *dest = reinterpret_cast<BufferDestination *>(info->dest);
+    dest->buffer->resize(cappedSize(dest, kDestinationChunk));
+    dest->pub.next_output_byte = reinterpret_cast<JOCTET *>(dest->buffer->data());
+    dest->pub.free_in_buffer = static_cast<size_t>(dest->buffer->size());
+}
+
+boolean emptyDestination(j_compress_ptr info) {
+    auto *dest = reinterpret_cast<BufferDestination *>(info->dest);
+    const qsizetype used = dest->buffer->size();
+    if (dest->limit > 0 && used > dest->limit) {
+        auto *manager = reinterpret_cast<ErrorManager *>(info->err);
+        manager->exceeded = true;
+        longjmp(manager->jump, 1);
+    }
+    dest->buffer->resize(cappedSize(dest, used * 2));
+    dest->pub.next_output_byte = reinterpret_cast<JOCTET *>(dest->buffer->data()) + used;
+    dest->pub.free_in_buffer = static_cast<size_t>(dest->buffer->size() - used);
+    return TRUE;
+}
+
+void termDestination(j_compress_ptr info) {
+    auto *dest = reinterpret_cast<BufferDestination *>(info->dest);
+    dest->buffer->resize(dest->buffer->size() - static_cast<qsizetype>(dest->pub.free_in_buffer));
+}
+
+void installDestination(j_compress_ptr info, QByteArray *buffer, qint64 limit) {
+    auto *dest = static_cast<BufferDestination *>((*info->mem->alloc_small)(
+        reinterpret_cast<j_common_ptr>(info),
+        JPOOL_PERMANENT,
+        sizeof(BufferDestination)
+    ));
+    dest->pub.init_destination = initDestination;
+    dest->pub.empty_output_buffer = emptyDestination;
+    dest->pub.term_destination = termDestination;
+    dest->buffer = buffer;
+    dest->limit = limit;
+    info->dest = &dest->pub;
+}
+
+J_COLOR_SPACE decodeColorSpace(J_COLOR_SPACE source) {
+    if (source == JCS_GRAYSCALE) {
+        return JCS_GRAYSCALE;
+    }
+    if (source == JCS_CMYK || source == JCS_YCCK) {
+        return JCS_CMYK;
+    }
+    return JCS_RGB;
+}
+
+void applySettings(j_compress_ptr info, const JpegEncodeSettings &settings) {
+#if defined(IMGCOMPRESS_HAS_MOZJPEG)
+    if (jpeg_c_int_param_supported(info, JINT_COMPRESS_PROFILE)) {
+        jpeg_c_set_int_param(info, JINT_COMPRESS_PROFILE, settings.trellis ? JCP_MAX_COMPRESSION : JCP_FASTEST);
+    }
+#endif
+    jpeg_set_defaults(info);
+#if defined(IMGCOMPRESS_HAS_MOZJPEG)
+    if (jpeg_c_bool_param_supported(info, JBOOLEAN_TRELLIS_QUANT)) {
+        jpeg_c_set_bool_param(info, JBOOLEAN_TRELLIS_QUANT, settings.trellis ? TRUE : FALSE);
+    }
+    if (jpeg_c_bool_param_supported(info, JBOOLEAN_TRELLIS_QUANT_DC)) {
+        jpeg_c_set_bool_param(info, JBOOLEAN_TRELLIS_QUANT_DC, settings.trellis ? TRUE : FALSE);
+    }
+    if (!settings.progressive && jpeg_c_bool_param_supported(info, JBOOLEAN_OPTIMIZE_SCANS)) {
+        jpeg_c_set_bool_param(info, JBOOLEAN_OPTIMIZE_SCANS, FALSE);
+    }
+#endif
+    jpeg_set_quality(info, settings.quality, TRUE);
+    info->optimize_coding = settings.optimize ? TRUE : FALSE;
+    if (settings.progressive) {
+        jpeg_simple_progression(info);
+    } else {
+        info->scan_info = nullptr;
+        info->num_scans = 0;
+    }
+}
+
+bool runRecompress(
+    const QByteArray &source,
+    const JpegEncodeSettings &settings,
+    qint64 sizeLimit,
+    QByteArray *output,
+    ErrorManager *errors
+) {
+    jpeg_decompress_struct decoder = {};
+    jpeg_compress_struct encoder = {};
+    decoder.err = &errors->base;
+    encoder.err = &errors->base;
+    if (setjmp(errors->jump)) {
+        jpeg_destroy_compress(&encoder);
+        jpeg_destroy_decompress(&decoder);
+        return false;
+    }
+    jpeg_create_decompress(&decoder);
+    jpeg_create_compress(&encoder);
+    jpeg_mem_src(
+        &decoder,
+        reinterpret_cast<unsigned char *>(const_cast<char *>(source.constData())),
+        static_cast<unsigned long>(source.size())
+    );
+    jpeg_read_header(&decoder, TRUE);
+    decoder.out_color_space = decodeColorSpace(decoder.jpeg_color_space);
+    jpeg_start_decompress(&decoder);
+    encoder.image_width = decoder.output_width;
+    encoder.image_height = decoder.output_height;
+    encoder.input_components = decoder.output_components;
+    encoder.in_color_space = decoder.out_color_space;
+    installDestination(&encoder, output, sizeLimit);
+    applySettings(&encoder, settings);
+    jpeg_start_compress(&encoder, TRUE);
+    const JDIMENSION stride = decoder.output_width * static_cast<JDIMENSION>(decoder.output_components);
+    JSAMPARRAY row = (*decoder.mem->alloc_sarray)(reinterpret_cast<j_common_ptr>(&decoder), JPOOL_IMAGE, stride, 1);
+    while (decoder.output_scanline < decoder.output_height) {
+        jpeg_read_scanlines(&decoder, row, 1);
+        jpeg_write_scanlines(&encoder, row, 1);
+    }
+    jpeg_finish_compress(&encoder);
+    jpeg_finish_decompress(&decoder);
+    jpeg_destroy_compress(&encoder);
+    jpeg_destroy_decompress(&decoder);
+    return errors->warnings == 0;
+}
+
+bool runEncode(
+    const QImage &image,
+    const JpegEncodeSettings &settings,
+    QByteArray *output,
+    ErrorManager *errors
+) {
+    jpeg_compress_struct encoder = {};
+    encoder.err = &errors->base;
+    if (setjmp(errors->jump)) {
+        jpeg_destroy_compress(&encoder);
+        return false;
+    }
+    jpeg_create_compress(&encoder);
+    const bool gray = image.format() == QImage::Format_Grayscale8;
+    encoder.image_width = static_cast<JDIMENSION>(image.width());
+    encoder.image_height = static_cast<JDIMENSION>(image.height());
+    encoder.input_components = gray ? 1 : 3;
+    encoder.in_color_space = gray ? JCS_GRAYSCALE : JCS_RGB;
+    installDestination(&encoder, output, 0);
+    applySettings(&encoder, settings);
+    jpeg_start_compress(&encoder, TRUE);
+    while (encoder.next_scanline < encoder.image_height) {
+        JSAMPROW row = const_cast<JSAMPLE *>(image.constScanLine(static_cast<int>(encoder.next_scanline)));
+        jpeg_write_scanlines(&encoder, &row, 1);
+    }
+    jpeg_finish_compress(&encoder);
+    jpeg_destroy_compress(&encoder);
+    return true;
+}
+
+bool runTranscode(const QByteArray &source, QByteArray *output, ErrorManager *errors) {
+    jpeg_decompress_struct decoder = {};
+    jpeg_compress_struct encoder = {};
+    decoder.err = &errors->base;
+    encoder.err = &errors->base;
+    if (setjmp(errors->jump)) {
+        jpeg_destroy_compress(&encoder);
+        jpeg_destroy_decompress(&decoder);
+        return false;
+    }
+    jpeg_create_decompress(&decoder);
+    jpeg_create_compress(&encoder);
+    jpeg_mem_src(
+        &decoder,
+        reinterpret_cast<unsigned char *>(const_cast<char *>(source.constData())),
+        static_cast<unsigned long>(source.size())
+    );
+    jpeg_read_header(&decoder, TRUE);
+    jvirt_barray_ptr *coefficients = jpeg_read_coefficients(&decoder);
+    jpeg_copy_critical_parameters(&decoder, &encoder);
+    encoder.optimize_coding = TRUE;
+    jpeg_simple_progression(&encoder);
+    installDestination(&encoder, output, 0);
+    jpeg_write_coefficients(&encoder, coefficients);
+    jpeg_finish_compress(&encoder);
+    jpeg_finish_decompress(&decoder);
+    jpeg_destroy_compress(&encoder);
+    jpeg_destroy_decompress(&decoder);
+    return errors->warnings == 0;
+}
+#endif
+}
+
+bool JpegCodec::isAvailable() {
+#if defined(IMGCOMPRESS_HAS_LIBJPEG)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool JpegCodec::supportsTrellis() {
+#if defined(IMGCOMPRESS_HAS_MOZJPEG)
+    return true;
+#else
+    return false;
+#endif
+}
+
+QString JpegCodec::backendName() {
+    if (!isAvailable()) {
+        return {};
+    }
+    return supportsTrellis() ? "mozjpeg" : "libjpeg-turbo";
+}
+
+JpegCodec::Status JpegCodec::recompress(
+    const QByteArray &source,
+    const JpegEncodeSettings &settings,
+    qint64 sizeLimit,
+    QByteArray *output,
+    QString *error
+) {
+#if defined(IMGCOMPRESS_HAS_LIBJPEG)
+    if (source.isEmpty() || !output) {
+        if (error) {
+            *error = "空文件";
+        }
+        return Status::Failed;
+    }
+    ErrorManager errors;
+    initErrorManager(&errors);
+    QByteArray encoded;
+    if (!runRecompress(source, settings, sizeLimit, &encoded, &errors)) {
+        if (errors.exceeded) {
+            return Status::TooLarge;
+        }
+        if (error) {
+            *error = QString::fromLocal8Bit(errors.message);
+        }
+        return Status::Failed;
+    }
+    if (sizeLimit > 0 && encoded.size() > sizeLimit) {
+        return Status::TooLarge;
+    }
+    *output = encoded;
+    return Status::Success;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(settings);
+    Q_UNUSED(sizeLimit);
+    Q_UNUSED(output);
+    if (error) {
+        *error = "未启用内置 JPEG 编码器";
+    }
+    return Status::Failed;
+#endif
+}
+
+bool JpegCodec::encode(
+    const QImage &image,
+    const JpegEncodeSettings &settings,
+    QByteArray *output,
+    QString *error
+) {
+#if defined(IMGCOMPRESS_HAS_LIBJPEG)
+    if (image.isNull() || !output) {
+        if (error) {
+            *error = "无效的像素数据";
+        }
+        return false;
+    }
+    const QImage pixels = image.format() == QImage::Format_Grayscale8
+        ? image
+        : image.convertToFormat(QImage::Format_RGB888);
+    ErrorManager errors;
+    initErrorManager(&errors);
+    QByteArray encoded;
+    if (!runEncode(pixels, settings, &encoded, &errors)) {
+        if (error) {
+            *error = QString::fromLocal8Bit(errors.message);
+        }
+        return false;
+    }
+    *output = encoded;
+    return true;
+#else
+    Q_UNUSED(image);
+    Q_UNUSED(settings);
+    Q_UNUSED(output);
+    if (error) {
+        *error = "未启用内置 JPEG 编码器";
+    }
+    return false;
+#endif
+}
+
+bool JpegCodec::transcode(const QByteArray &source, QByteArray *output, QString *error) {
+#if defined(IMGCOMPRESS_HAS_LIBJPEG)
+    if (source.isEmpty() || !output) {
+        if (error) {
+            *error = "空文件";
+        }
+        return false;
+    }
+    ErrorManager errors;
+    initErrorManager(&errors);
+    QByteArray encoded;
+    if (!runTranscode(source, &encoded, &errors)) {
+        if (error) {
+            *error = QString::fromLocal8Bit(errors.message);
+        }
+        return false;
+    }
+    *output = encoded;
+    return true;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(output);
+    if (error) {
+        *error = "未启用内置 JPEG 转码器";
+    }
+    return false;
+#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+class QImage;
+
+struct JpegEncodeSettings {
+    int quality;
+    bool progressive;
+    bool optimize;
+    bool trellis;
+};
+
+class JpegCodec {
+public:
+    enum class Status {
+        Success,
+        TooLarge,
+        Failed
+    };
+
+    static bool isAvailable();
+    static bool supportsTrellis();
+    static QString backendName();
+    static Status recompress(
+        const QByteArray &source,
+        const JpegEncodeSettings &settings,
+        qint64 sizeLimit,
+        QByteArray *output,
+        QString *error
+    );
+    static bool encode(
+        const QImage &image,
+        const JpegEncodeSettings &settings,
+        QByteArray *output,
+        QString *error
+    );
+    static bool transcode(
+        const QByteArray &source,
+        QByteArray *output,
+        QString *error
+    );
+};
@@ -0,0 +1,182 @@
+#include "OutputCache.h"
+
+#include "FastHash.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace {
+const char kMagic[8] = {'I', 'M', 'G', 'C', 'O', 'C', '0', '1'};
+const int kHeaderSize = 24;
+const qint64 kDefaultLimitMb = 1024;
+
+struct CacheObject {
+    QString path;
+    qint64 size;
+    qint64 touchedMs;
+};
+
+QString cacheRoot;
+qint64 limitBytes = 0;
+quint64 settingsSeed = 0;
+std::atomic<qint64> usedBytes{0};
+std::atomic<qint64> hitCount{0};
+std::atomic<qint64> missCount{0};
+std::atomic<bool> evicting{false};
+
+QString objectPath(const QString &key) {
+    return QDir(cacheRoot).filePath(key.left(2) + "/" + key);
+}
+
+QVector<CacheObject> scanObjects() {
+    QVector<CacheObject> objects;
+    QDirIterator it(cacheRoot, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QFileInfo info(it.next());
+        if (info.fileName().size() != 32) {
+            continue;
+        }
+        objects.append({info.absoluteFilePath(), info.size(), info.lastModified().toMSecsSinceEpoch()});
+    }
+    return objects;
+}
+
+void evict() {
+    bool expected = false;
+    if (!evicting.compare_exchange_strong(expected, true)) {
+        return;
+    }
+    QVector<CacheObject> objects = scanObjects();
+    std::sort(objects.begin(), objects.end(), [](const CacheObject &a, const CacheObject &b) {
+        return a.touchedMs < b.touchedMs;
+    });
+    qint64 total = 0;
+    for (const CacheObject &object : objects) {
+        total += object.size;
+    }
+    const qint64 target = limitBytes - limitBytes / 10;
+    for (int i = 0; i < objects.size() && total > target; i += 1) {
+        if (QFile::remove(objects[i].path)) {
+            total -= objects[i].size;
+        }
+    }
+    usedBytes.store(total);
+    evicting.store(false);
+}
+
+bool decode(const QByteArray &raw, CachedOutput *output) {
+    if (raw.size() < kHeaderSize || memcmp(raw.constData(), kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    const uchar *header = reinterpret_cast<const uchar *>(raw.constData());
+    const qint64 engineSize = qFromLittleEndian<quint32>(header + 8);
+    const qint64 messageSize = qFromLittleEndian<quint32>(header + 12);
+    const qint64 dataSize = qFromLittleEndian<qint64>(header + 16);
+    if (kHeaderSize + engineSize + messageSize + dataSize != raw.size() || dataSize <= 0) {
+        return false;
+    }
+    output->engine = QString::fromUtf8(raw.constData() + kHeaderSize, engineSize);
+    output->message = QString::fromUtf8(raw.constData() + kHeaderSize + engineSize, messageSize);
+    output->data = raw.mid(kHeaderSize + engineSize + messageSize);
+    return true;
+}
+
+QByteArray encode(const CachedOutput &output) {
+    const QByteArray engine = output.engine.toUtf8();
+    const QByteArray message = output.message.toUtf8();
+    QByteArray raw(kHeaderSize, '\0');
+    uchar *header = reinterpret_cast<uchar *>(raw.data());
+    memcpy(header, kMagic, sizeof(kMagic));
+    qToLittleEndian<quint32>(static_cast<quint32>(engine.size()), header + 8);
+    qToLittleEndian<quint32>(static_cast<quint32>(message.size()), header + 12);
+    qToLittleEndian<qint64>(output.data.size(), header + 16);
+    raw.reserve(kHeaderSize + engine.size() + message.size() + output.data.size());
+    raw.append(engine);
+    raw.append(message);
+    raw.append(output.data);
+    return raw;
+}
+}
+
+void OutputCache::configure(const QString &directory, qint64 limitMb, quint64 engineHash) {
+    cacheRoot = directory.isEmpty() ? QString() : QDir(directory).absolutePath();
+    limitBytes = (limitMb > 0 ? limitMb : kDefaultLimitMb) * 1024 * 1024;
+    settingsSeed = engineHash;
+    hitCount.store(0);
+    missCount.store(0);
+    usedBytes.store(0);
+    if (cacheRoot.isEmpty()) {
+        return;
+    }
+    if (!QDir().mkpath(cacheRoot)) {
+        cacheRoot.clear();
+        return;
+    }
+    qint64 total = 0;
+    for (const CacheObject &object : scanObjects()) {
+        total += object.size;
+    }
+    usedBytes.store(total);
+    if (total > limitBytes) {
+        evict();
+    }
+}
+
+bool OutputCache::isEnabled() {
+    return !cacheRoot.isEmpty();
+}
+
+QString OutputCache::key(quint64 contentHash, qint64 size, quint64 optionsHash) {
+    uchar settings[16];
+    qToLittleEndian<qint64>(size, settings);
+    qToLittleEndian<quint64>(optionsHash, settings + 8);
+    const quint64 settingsHash = FastHash::hash(reinterpret_cast<const char *>(settings), sizeof(settings), settingsSeed);
+    return QString("%1%2").arg(contentHash, 16, 16, QChar('0')).arg(settingsHash, 16, 16, QChar('0'));
+}
+
+bool OutputCache::fetch(const QString &key, CachedOutput *output) {
+    if (!isEnabled()) {
+        return false;
+    }
+    QFile file(objectPath(key));
+    if (!file.open(QIODevice::ReadOnly) || !decode(file.readAll(), output)) {
+        missCount.fetch_add(1);
+        return false;
+    }
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    hitCount.fetch_add(1);
+    return true;
+}
+
+void OutputCache::store(const QString &key, const CachedOutput &output) {
+    if (!isEnabled() || output.data.isEmpty()) {
+        return;
+    }
+    const QString path = objectPath(key);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    const QByteArray raw = encode(output);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(raw) != raw.size() || !file.commit()) {
+        return;
+    }
+    if (usedBytes.fetch_add(raw.size()) + raw.size() > limitBytes) {
+        evict();
+    }
+}
+
+qint64 OutputCache::hits() {
+    return hitCount.load();
+}
+
+qint64 OutputCache::misses() {
+    return missCount.load();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+struct CachedOutput {
+    QByteArray data;
+    QString engine;
+    QString message;
+};
+
+class OutputCache {
+public:
+    static void configure(const QString &directory, qint64 limitMb, quint64 engineHash);
+    static bool isEnabled();
+    static QString key(quint64 contentHash, qint64 size, quint64 optionsHash);
+    static bool fetch(const QString &key, CachedOutput *output);
+    static void store(const QString &key, const CachedOutput &output);
+    static qint64 hits();
+    static qint64 misses();
+};
@@ -0,0 +1,240 @@
+#include "PngEncoder.h"
+
+#include <QImage>
+
+#include <cstring>
+
+#if defined(IMGCOMPRESS_HAS_LIBPNG)
+#include <csetjmp>
+
+#include <png.h>
+#include <zlib.h>
+#endif
+
+namespace {
+#if defined(IMGCOMPRESS_HAS_LIBPNG)
+struct WriteState {
+    QByteArray *buffer;
+    char message[256];
+};
+
+void onWrite(png_structp png, png_bytep data, png_size_t length) {
+    auto *state = static_cast<WriteState *>(png_get_io_ptr(png));
+    state->buffer->append(reinterpret_cast<const char *>(data), static_cast<qsizetype>(length));
+}
+
+void onFlush(png_structp) {}
+
+void onError(png_structp png, png_const_charp message) {
+    auto *state = static_cast<WriteState *>(png_get_error_ptr(png));
+    qstrncpy(state->message, message, sizeof(state->message));
+    png_longjmp(png, 1);
+}
+
+void onWarning(png_structp, png_const_charp) {}
+
+int filterFlags(PngFilter filter) {
+    switch (filter) {
+    case PngFilter::None:
+        return PNG_FILTER_NONE;
+    case PngFilter::Sub:
+        return PNG_FILTER_SUB;
+    case PngFilter::Up:
+        return PNG_FILTER_UP;
+    case PngFilter::Average:
+        return PNG_FILTER_AVG;
+    case PngFilter::Paeth:
+        return PNG_FILTER_PAETH;
+    case PngFilter::Adaptive:
+        return PNG_ALL_FILTERS;
+    }
+    return PNG_ALL_FILTERS;
+}
+
+int strategyValue(PngStrategy strategy) {
+    switch (strategy) {
+    case PngStrategy::Default:
+        return Z_DEFAULT_STRATEGY;
+    case PngStrategy::Filtered:
+        return Z_FILTERED;
+    case PngStrategy::HuffmanOnly:
+        return Z_HUFFMAN_ONLY;
+    case PngStrategy::Rle:
+        return Z_RLE;
+    }
+    return Z_DEFAULT_STRATEGY;
+}
+
+void writeAncillary(png_structp png, png_infop info, const PngAncillary &ancillary) {
+    if (!ancillary.iccProfile.isEmpty()) {
+        png_set_iCCP(
+            png,
+            info,
+            ancillary.iccName.isEmpty() ? "ICC profile" : ancillary.iccName.constData(),
+            PNG_COMPRESSION_TYPE_BASE,
+            reinterpret_cast<png_const_bytep>(ancillary.iccProfile.constData()),
+            static_cast<png_uint_32>(ancillary.iccProfile.size())
+        );
+    } else if (ancillary.srgbIntent >= 0) {
+        png_set_sRGB(png, info, ancillary.srgbIntent);
+    }
+    if (ancillary.gamma > 0) {
+        png_set_gAMA_fixed(png, info, ancillary.gamma);
+    }
+    if (ancillary.hasChromaticities) {
+        const int *c = ancillary.chromaticities;
+        png_set_cHRM_fixed(png, info, c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7]);
+    }
+    if (ancillary.hasPhysicalSize) {
+        png_set_pHYs(png, info, ancillary.physicalX, ancillary.physicalY, ancillary.physicalUnit);
+    }
+}
+
+bool runEncode(const PngEncodeImage &image, const PngEncodeSettings &settings, WriteState *state) {
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, state, onError, onWarning);
+    if (!png) {
+        return false;
+    }
+    png_infop info = png_create_info_struct(png);
+    if (!info) {
+        png_destroy_write_struct(&png, nullptr);
+        return false;
+    }
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        return false;
+    }
+    png_set_write_fn(png, state, onWrite, onFlush);
+    png_set_IHDR(
+        png,
+        info,
+        static_cast<png_uint_32>(image.width),
+        static_cast<png_uint_32>(image.height),
+        image.bitDepth,
+        static_cast<int>(image.colorType),
+        PNG_INTERLACE_NONE,
+        PNG_COMPRESSION_TYPE_DEFAULT,
+        PNG_FILTER_TYPE_DEFAULT
+    );
+    if (image.colorType == PngColorType::Palette) {
+        png_set_PLTE(
+            png,
+            info,
+            reinterpret_cast<png_const_colorp>(image.palette.constData()),
+            static_cast<int>(image.palette.size() / 3)
+        );
+    }
+    if (!image.transparency.isEmpty()) {
+        png_set_tRNS(
+            png,
+            info,
+            reinterpret_cast<png_const_bytep>(image.transparency.constData()),
+            static_cast<int>(image.transparency.size()),
+            nullptr
+        );
+    }
+    writeAncillary(png, info, image.ancillary);
+    png_set_filter(png, PNG_FILTER_TYPE_BASE, filterFlags(settings.filter));
+    png_set_compression_level(png, settings.level);
+    png_set_compression_strategy(png, strategyValue(settings.strategy));
+    png_set_compression_mem_level(png, 9);
+    png_write_info(png, info);
+    if (image.bitDepth < 8) {
+        png_set_packing(png);
+    }
+    const qsizetype stride = image.rowBytes();
+    const auto *rows = reinterpret_cast<png_const_bytep>(image.pixels.constData());
+    for (int y = 0; y < image.height; y += 1) {
+        png_write_row(png, rows + stride * y);
+    }
+    png_write_end(png, nullptr);
+    png_destroy_write_struct(&png, &info);
+    return true;
+}
+#endif
+}
+
+int PngEncodeImage::channels() const {
+    switch (colorType) {
+    case PngColorType::Gray:
+    case PngColorType::Palette:
+        return 1;
+    case PngColorType::GrayAlpha:
+        return 2;
+    case PngColorType::Rgb:
+        return 3;
+    case PngColorType::Rgba:
+        return 4;
+    }
+    return 4;
+}
+
+qsizetype PngEncodeImage::rowBytes() const {
+    const int sampleBytes = bitDepth == 16 ? 2 : 1;
+    return static_cast<qsizetype>(width) * channels() * sampleBytes;
+}
+
+bool PngEncoder::isAvailable() {
+#if defined(IMGCOMPRESS_HAS_LIBPNG)
+    return true;
+#else
+    return false;
+#endif
+}
+
+PngEncodeImage PngEncoder::imageData(const QImage &image) {
+    QImage pixels;
+    PngColorType colorType = PngColorType::Rgb;
+    if (image.format() == QImage::Format_Grayscale8) {
+        pixels = image;
+        colorType = PngColorType::Gray;
+    } else if (image.hasAlphaChannel()) {
+        pixels = image.convertToFormat(QImage::Format_RGBA8888);
+        colorType = PngColorType::Rgba;
+    } else {
+        pixels = image.convertToFormat(QImage::Format_RGB888);
+    }
+    PngEncodeImage data{pixels.width(), pixels.height(), colorType, 8, QByteArray(), QByteArray(), QByteArray()};
+    const qsizetype stride = data.rowBytes();
+    data.pixels.resize(stride * data.height);
+    for (int y = 0; y < data.height; y += 1) {
+        memcpy(data.pixels.data() + stride * y, pixels.constScanLine(y), static_cast<size_t>(stride));
+    }
+    return data;
+}
+
+bool PngEncoder::encode(
+    const PngEncodeImage &image,
+    const PngEncodeSettings &settings,
+    QByteArray *output,
+    QString *error
+) {
+#if defined(IMGCOMPRESS_HAS_LIBPNG)
+    if (!output || image.width <= 0 || image.height <= 0
+        || image.pixels.size() < image.rowBytes() * image.height) {
+        if (error) {
+            *error = "无效的像素数据";
+        }
+        return false;
+    }
+    QByteArray encoded;
+    encoded.reserve(image.pixels.size() / 2);
+    WriteState state = {&encoded, {0}};
+    if (!runEncode(image, settings, &state)) {
+        if (error) {
+            *error = QString::fromLocal8Bit(state.message);
+        }
+        return false;
+    }
+    *output = encoded;
+    return true;
+#else
+    Q_UNUSED(image);
+    Q_UNUSED(settings);
+    Q_UNUSED(output);
+    if (error) {
+        *error = "未启用内置 PNG 编码器";
+    }
+    return false;
+#endif
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+class QImage;
+
+enum class PngColorType {
+    Gray = 0,
+    Rgb = 2,
+    Palette = 3,
+    GrayAlpha = 4,
+    Rgba = 6
+};
+
+enum class PngFilter {
+    None,
+    Sub,
+    Up,
+    Average,
+    Paeth,
+    Adaptive
+};
+
+enum class PngStrategy {
+    Default,
+    Filtered,
+    HuffmanOnly,
+    Rle
+};
+
+struct PngAncillary {
+    int gamma = 0;
+    int srgbIntent = -1;
+    QByteArray iccName;
+    QByteArray iccProfile;
+    bool hasChromaticities = false;
+    int chromaticities[8] = {};
+    bool hasPhysicalSize = false;
+    quint32 physicalX = 0;
+    quint32 physicalY = 0;
+    int physicalUnit = 0;
+};
+
+struct PngEncodeImage {
+    int width;
+    int height;
+    PngColorType colorType;
+    int bitDepth;
+    QByteArray pixels;
+    QByteArray palette;
+    QByteArray transparency;
+    PngAncillary ancillary;
+
+    int channels() const;
+    qsizetype rowBytes() const;
+};
+
+struct PngEncodeSettings {
+    PngFilter filter;
+    int level;
+    PngStrategy strategy;
+};
+
+class PngEncoder {
+public:
+    static bool isAvailable();
+    static PngEncodeImage imageData(const QImage &image);
+    static bool encode(
+        const PngEncodeImage &image,
+        const PngEncodeSettings &settings,
+        QByteArray *output,
+        QString *error
+    );
+};
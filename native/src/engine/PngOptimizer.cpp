@@ -0,0 +1,558 @@
+#include "PngOptimizer.h"
+
+#include "PngEncoder.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QThreadPool>
+#include <QVector>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(IMGCOMPRESS_HAS_LIBPNG)
+#include <csetjmp>
+
+#include <png.h>
+#endif
+
+namespace {
+#if defined(IMGCOMPRESS_HAS_LIBPNG)
+struct Raster {
+    int width;
+    int height;
+    int channels;
+    int bitDepth;
+    QByteArray pixels;
+};
+
+struct ReadState {
+    const QByteArray *data;
+    qsizetype offset;
+    char message[256];
+};
+
+void onRead(png_structp png, png_bytep out, png_size_t length) {
+    auto *state = static_cast<ReadState *>(png_get_io_ptr(png));
+    if (state->offset + static_cast<qsizetype>(length) > state->data->size()) {
+        png_error(png, "Read Error: premature end of data");
+    }
+    memcpy(out, state->data->constData() + state->offset, length);
+    state->offset += static_cast<qsizetype>(length);
+}
+
+void onError(png_structp png, png_const_charp message) {
+    auto *state = static_cast<ReadState *>(png_get_error_ptr(png));
+    qstrncpy(state->message, message, sizeof(state->message));
+    png_longjmp(png, 1);
+}
+
+void onWarning(png_structp, png_const_charp) {}
+
+void readAncillary(png_structp png, png_infop info, PngAncillary *ancillary) {
+    png_fixed_point gamma = 0;
+    if (png_get_gAMA_fixed(png, info, &gamma)) {
+        ancillary->gamma = gamma;
+    }
+    int intent = 0;
+    if (png_get_sRGB(png, info, &intent)) {
+        ancillary->srgbIntent = intent;
+    }
+    png_charp name = nullptr;
+    int compression = 0;
+    png_bytep profile = nullptr;
+    png_uint_32 profileLength = 0;
+    if (png_get_iCCP(png, info, &name, &compression, &profile, &profileLength) && profile && profileLength > 0) {
+        ancillary->iccName = QByteArray(name);
+        ancillary->iccProfile = QByteArray(reinterpret_cast<const char *>(profile), static_cast<qsizetype>(profileLength));
+    }
+    png_fixed_point c[8] = {};
+    if (png_get_cHRM_fixed(png, info, &c[0], &c[1], &c[2], &c[3], &c[4], &c[5], &c[6], &c[7])) {
+        ancillary->hasChromaticities = true;
+        std::copy(c, c + 8, ancillary->chromaticities);
+    }
+    png_uint_32 physicalX = 0;
+    png_uint_32 physicalY = 0;
+    int unit = 0;
+    if (png_get_pHYs(png, info, &physicalX, &physicalY, &unit)) {
+        ancillary->hasPhysicalSize = true;
+        ancillary->physicalX = physicalX;
+        ancillary->physicalY = physicalY;
+        ancillary->physicalUnit = unit;
+    }
+}
+
+bool runDecode(ReadState *state, Raster *raster, PngAncillary *ancillary, QVector<png_bytep> *rows) {
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, state, onError, onWarning);
+    if (!png) {
+        return false;
+    }
+    png_infop info = png_create_info_struct(png);
+    if (!info) {
+        png_destroy_read_struct(&png, nullptr, nullptr);
+        return false;
+    }
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return false;
+    }
+    png_set_read_fn(png, state, onRead);
+    png_read_info(png, info);
+    png_set_expand(png);
+    png_set_interlace_handling(png);
+    png_read_update_info(png, info);
+    raster->width = static_cast<int>(png_get_image_width(png, info));
+    raster->height = static_cast<int>(png_get_image_height(png, info));
+    raster->channels = png_get_channels(png, info);
+    raster->bitDepth = png_get_bit_depth(png, info);
+    const qsizetype stride = static_cast<qsizetype>(png_get_rowbytes(png, info));
+    raster->pixels.resize(stride * raster->height);
+    rows->resize(raster->height);
+    auto *base = reinterpret_cast<png_bytep>(raster->pixels.data());
+    for (int y = 0; y < raster->height; y += 1) {
+        (*rows)[y] = base + stride * y;
+    }
+    png_read_image(png, rows->data());
+    png_read_end(png, info);
+    readAncillary(png, info, ancillary);
+    png_destroy_read_struct(&png, &info, nullptr);
+    return true;
+}
+
+bool hasAnimationChunk(const QByteArray &data) {
+    const auto *bytes = reinterpret_cast<const uchar *>(data.constData());
+    qsizetype offset = 8;
+    while (offset + 8 <= data.size()) {
+        const uchar *chunk = bytes + offset;
+        const quint32 length = (quint32(chunk[0]) << 24) | (quint32(chunk[1]) << 16)
+            | (quint32(chunk[2]) << 8) | quint32(chunk[3]);
+        if (memcmp(chunk + 4, "acTL", 4) == 0) {
+            return true;
+        }
+        if (memcmp(chunk + 4, "IDAT", 4) == 0) {
+            return false;
+        }
+        offset += 12 + static_cast<qsizetype>(length);
+    }
+    return false;
+}
+
+int sampleBytes(const Raster &raster) {
+    return raster.bitDepth == 16 ? 2 : 1;
+}
+
+bool canReduceTo8Bit(const Raster &raster) {
+    if (raster.bitDepth != 16) {
+        return false;
+    }
+    const auto *data = reinterpret_cast<const uchar *>(raster.pixels.constData());
+    const qsizetype size = raster.pixels.size();
+    for (qsizetype i = 0; i + 1 < size; i += 2) {
+        if (data[i] != data[i + 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Raster reduceTo8Bit(const Raster &raster) {
+    Raster reduced{raster.width, raster.height, raster.channels, 8, QByteArray()};
+    const qsizetype samples = raster.pixels.size() / 2;
+    reduced.pixels.resize(samples);
+    const char *source = raster.pixels.constData();
+    char *target = reduced.pixels.data();
+    for (qsizetype i = 0; i < samples; i += 1) {
+        target[i] = source[i * 2];
+    }
+    return reduced;
+}
+
+bool hasOpaqueAlpha(const Raster &raster) {
+    if (raster.channels != 2 && raster.channels != 4) {
+        return false;
+    }
+    const int bytes = sampleBytes(raster);
+    const qsizetype pixelBytes = static_cast<qsizetype>(raster.channels) * bytes;
+    const auto *data = reinterpret_cast<const uchar *>(raster.pixels.constData());
+    const qsizetype size = raster.pixels.size();
+    for (qsizetype i = pixelBytes - bytes; i < size; i += pixelBytes) {
+        if (data[i] != 0xff || (bytes == 2 && data[i + 1] != 0xff)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Raster removeAlpha(const Raster &raster) {
+    const int bytes = sampleBytes(raster);
+    Raster reduced{raster.width, raster.height, raster.channels - 1, raster.bitDepth, QByteArray()};
+    const qsizetype pixels = static_cast<qsizetype>(raster.width) * raster.height;
+    const qsizetype sourceBytes = static_cast<qsizetype>(raster.channels) * bytes;
+    const qsizetype targetBytes = static_cast<qsizetype>(reduced.channels) * bytes;
+    reduced.pixels.resize(pixels * targetBytes);
+    const char *source = raster.pixels.constData();
+    char *target = reduced.pixels.data();
+    for (qsizetype i = 0; i < pixels; i += 1) {
+        memcpy(target + i * targetBytes, source + i * sourceBytes, static_cast<size_t>(targetBytes));
+    }
+    return reduced;
+}
+
+bool isGrayscale(const Raster &raster) {
+    if (raster.channels < 3) {
+        return false;
+    }
+    const int bytes = sampleBytes(raster);
+    const qsizetype pixelBytes = static_cast<qsizetype>(raster.channels) * bytes;
+    const char *data = raster.pixels.constData();
+    const qsizetype size = raster.pixels.size();
+    for (qsizetype i = 0; i < size; i += pixelBytes) {
+        if (memcmp(data + i, data + i + bytes, static_cast<size_t>(bytes)) != 0
+            || memcmp(data + i, data + i + bytes * 2, static_cast<size_t>(bytes)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Raster toGrayscale(const Raster &raster) {
+    const int bytes = sampleBytes(raster);
+    const bool alpha = raster.channels == 4;
+    Raster reduced{raster.width, raster.height, alpha ? 2 : 1, raster.bitDepth, QByteArray()};
+    const qsizetype pixels = static_cast<qsizetype>(raster.width) * raster.height;
+    const qsizetype sourceBytes = static_cast<qsizetype>(raster.channels) * bytes;
+    const qsizetype targetBytes = static_cast<qsizetype>(reduced.channels) * bytes;
+    reduced.pixels.resize(pixels * targetBytes);
+    const char *source = raster.pixels.constData();
+    char *target = reduced.pixels.data();
+    for (qsizetype i = 0; i < pixels; i += 1) {
+        memcpy(target + i * targetBytes, source + i * sourceBytes, static_cast<size_t>(bytes));
+        if (alpha) {
+            memcpy(target + i * targetBytes + bytes, source + i * sourceBytes + bytes * 3, static_cast<size_t>(bytes));
+        }
+    }
+    return reduced;
+}
+
+int grayBitDepth(const Raster &raster) {
+    if (raster.channels != 1 || raster.bitDepth != 8) {
+        return raster.bitDepth;
+    }
+    bool fits4 = true;
+    bool fits2 = true;
+    bool fits1 = true;
+    const auto *data = reinterpret_cast<const uchar *>(raster.pixels.constData());
+    const qsizetype size = raster.pixels.size();
+    for (qsizetype i = 0; i < size && fits4; i += 1) {
+        const int value = data[i];
+        fits4 = value % 17 == 0;
+        fits2 = fits2 && value % 85 == 0;
+        fits1 = fits1 && (value == 0 || value == 255);
+    }
+    if (fits1) {
+        return 1;
+    }
+    if (fits2) {
+        return 2;
+    }
+    return fits4 ? 4 : 8;
+}
+
+PngColorType colorTypeFor(int channels) {
+    switch (channels) {
+    case 1:
+        return PngColorType::Gray;
+    case 2:
+        return PngColorType::GrayAlpha;
+    case 3:
+        return PngColorType::Rgb;
+    default:
+        return PngColorType::Rgba;
+    }
+}
+
+PngEncodeImage truecolorImage(const Raster &raster, const PngAncillary &ancillary) {
+    PngEncodeImage image{
+        raster.width,
+        raster.height,
+        colorTypeFor(raster.channels),
+        raster.bitDepth,
+        raster.pixels,
+        QByteArray(),
+        QByteArray(),
+        ancillary
+    };
+    const int depth = grayBitDepth(raster);
+    if (depth < 8) {
+        const int divisor = 255 / ((1 << depth) - 1);
+        char *data = image.pixels.data();
+        const qsizetype size = image.pixels.size();
+        for (qsizetype i = 0; i < size; i += 1) {
+            data[i] = static_cast<char>(static_cast<uchar>(data[i]) / divisor);
+        }
+        image.bitDepth = depth;
+    }
+    return image;
+}
+
+quint32 colorKey(const uchar *pixel, int channels) {
+    switch (channels) {
+    case 1:
+        return (0xffu << 24) | (quint32(pixel[0]) << 16) | (quint32(pixel[0]) << 8) | pixel[0];
+    case 2:
+        return (quint32(pixel[1]) << 24) | (quint32(pixel[0]) << 16) | (quint32(pixel[0]) << 8) | pixel[0];
+    case 3:
+        return (0xffu << 24) | (quint32(pixel[0]) << 16) | (quint32(pixel[1]) << 8) | pixel[2];
+    default:
+        return (quint32(pixel[3]) << 24) | (quint32(pixel[0]) << 16) | (quint32(pixel[1]) << 8) | pixel[2];
+    }
+}
+
+int paletteBitDepth(int colors) {
+    if (colors <= 2) {
+        return 1;
+    }
+    if (colors <= 4) {
+        return 2;
+    }
+    if (colors <= 16) {
+        return 4;
+    }
+    return 8;
+}
+
+bool paletteImage(const Raster &raster, const PngAncillary &ancillary, PngEncodeImage *image) {
+    if (raster.bitDepth != 8) {
+        return false;
+    }
+    const int channels = raster.channels;
+    const auto *data = reinterpret_cast<const uchar *>(raster.pixels.constData());
+    const qsizetype pixels = static_cast<qsizetype>(raster.width) * raster.height;
+    if (pixels == 0) {
+        return false;
+    }
+    QHash<quint32, qint64> frequency;
+    quint32 runKey = colorKey(data, channels);
+    qint64 runLength = 0;
+    for (qsizetype i = 0; i < pixels; i += 1) {
+        const quint32 key = colorKey(data + i * channels, channels);
+        if (key == runKey) {
+            runLength += 1;
+            continue;
+        }
+        frequency[runKey] += runLength;
+        if (frequency.size() > 256) {
+            return false;
+        }
+        runKey = key;
+        runLength = 1;
+    }
+    frequency[runKey] += runLength;
+    if (frequency.size() > 256) {
+        return false;
+    }
+    QVector<QPair<quint32, qint64>> entries;
+    entries.reserve(frequency.size());
+    for (auto it = frequency.constBegin(); it != frequency.constEnd(); ++it) {
+        entries.append(qMakePair(it.key(), it.value()));
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+        const bool aTransparent = (a.first >> 24) != 0xff;
+        const bool bTransparent = (b.first >> 24) != 0xff;
+        if (aTransparent != bTransparent) {
+            return aTransparent;
+        }
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return a.first < b.first;
+    });
+    QHash<quint32, int> indexes;
+    QByteArray palette(entries.size() * 3, '\0');
+    QByteArray transparency;
+    for (int i = 0; i < entries.size(); i += 1) {
+        const quint32 key = entries[i].first;
+        indexes.insert(key, i);
+        palette[i * 3] = static_cast<char>((key >> 16) & 0xff);
+        palette[i * 3 + 1] = static_cast<char>((key >> 8) & 0xff);
+        palette[i * 3 + 2] = static_cast<char>(key & 0xff);
+        if ((key >> 24) != 0xff) {
+            transparency.append(static_cast<char>(key >> 24));
+        }
+    }
+    QByteArray indexed(pixels, '\0');
+    quint32 lastKey = colorKey(data, channels);
+    int lastIndex = indexes.value(lastKey);
+    for (qsizetype i = 0; i < pixels; i += 1) {
+        const quint32 key = colorKey(data + i * channels, channels);
+        if (key != lastKey) {
+            lastKey = key;
+            lastIndex = indexes.value(key);
+        }
+        indexed[i] = static_cast<char>(lastIndex);
+    }
+    *image = {
+        raster.width,
+        raster.height,
+        PngColorType::Palette,
+        paletteBitDepth(static_cast<int>(entries.size())),
+        indexed,
+        palette,
+        transparency,
+        ancillary
+    };
+    return true;
+}
+
+QVector<PngEncodeSettings> trialSettings(int level, bool indexed) {
+    QVector<PngFilter> filters;
+    QVector<PngStrategy> strategies;
+    if (level <= 1) {
+        filters = {indexed ? PngFilter::None : PngFilter::Adaptive};
+        strategies = {PngStrategy::Default};
+    } else if (level == 2) {
+        filters = {PngFilter::None, PngFilter::Up, PngFilter::Paeth, PngFilter::Adaptive};
+        strategies = {PngStrategy::Default, PngStrategy::Filtered};
+    } else {
+        filters = {
+            PngFilter::None,
+            PngFilter::Sub,
+            PngFilter::Up,
+            PngFilter::Average,
+            PngFilter::Paeth,
+            PngFilter::Adaptive
+        };
+        strategies = {PngStrategy::Default, PngStrategy::Filtered, PngStrategy::Rle};
+    }
+    QVector<PngEncodeSettings> trials;
+    for (const PngFilter filter : filters) {
+        for (const PngStrategy strategy : strategies) {
+            trials.append({filter, 9, strategy});
+        }
+    }
+    return trials;
+}
+#endif
+}
+
+bool PngOptimizer::isAvailable() {
+#if defined(IMGCOMPRESS_HAS_LIBPNG)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PngOptimizer::optimize(
+    const QByteArray &source,
+    const PngOptimizeSettings &settings,
+    QByteArray *output,
+    QString *error
+) {
+#if defined(IMGCOMPRESS_HAS_LIBPNG)
+    if (source.isEmpty() || !output) {
+        if (error) {
+            *error = "空文件";
+        }
+        return false;
+    }
+    if (hasAnimationChunk(source)) {
+        if (error) {
+            *error = "APNG 动画不支持内置优化";
+        }
+        return false;
+    }
+    ReadState state{&source, 0, {0}};
+    Raster raster{0, 0, 0, 0, QByteArray()};
+    PngAncillary ancillary;
+    QVector<png_bytep> rows;
+    if (!runDecode(&state, &raster, &ancillary, &rows)) {
+        if (error) {
+            *error = QString::fromLocal8Bit(state.message);
+        }
+        return false;
+    }
+    rows.clear();
+    const bool hasProfile = !ancillary.iccProfile.isEmpty();
+    const bool sourceColor = raster.channels >= 3;
+    if (canReduceTo8Bit(raster)) {
+        raster = reduceTo8Bit(raster);
+    }
+    if (hasOpaqueAlpha(raster)) {
+        raster = removeAlpha(raster);
+    }
+    if (!hasProfile && isGrayscale(raster)) {
+        raster = toGrayscale(raster);
+    }
+    QVector<PngEncodeImage> candidates;
+    PngEncodeImage indexed;
+    const bool allowPalette = !hasProfile || sourceColor;
+    const bool hasPalette = allowPalette && paletteImage(raster, ancillary, &indexed);
+    if (hasPalette) {
+        candidates.append(indexed);
+    }
+    if (!hasPalette || settings.level >= 2 || raster.channels == 1) {
+        candidates.append(truecolorImage(raster, ancillary));
+    }
+    struct Trial {
+        const PngEncodeImage *image;
+        PngEncodeSettings encode;
+    };
+    QVector<Trial> trials;
+    for (const PngEncodeImage &candidate : candidates) {
+        const bool lowDepth = candidate.colorType == PngColorType::Palette || candidate.bitDepth < 8;
+        for (const PngEncodeSettings &encode : trialSettings(settings.level, lowDepth)) {
+            trials.append({&candidate, encode});
+        }
+    }
+    QMutex bestMutex;
+    QByteArray best;
+    QString lastError;
+    auto runTrial = [&](const Trial &trial) {
+        QByteArray encoded;
+        QString trialError;
+        const bool ok = PngEncoder::encode(*trial.image, trial.encode, &encoded, &trialError);
+        QMutexLocker locker(&bestMutex);
+        if (!ok) {
+            lastError = trialError;
+            return;
+        }
+        if (best.isEmpty() || encoded.size() < best.size()) {
+            best = encoded;
+        }
+    };
+    const int threads = qMin(qMax(1, settings.threads), static_cast<int>(trials.size()));
+    if (threads <= 1) {
+        for (const Trial &trial : trials) {
+            runTrial(trial);
+        }
+    } else {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        for (const Trial &trial : trials) {
+            pool.start([&runTrial, trial]() {
+                runTrial(trial);
+            });
+        }
+        pool.waitForDone();
+    }
+    if (best.isEmpty()) {
+        if (error) {
+            *error = lastError.isEmpty() ? QString("PNG 编码失败") : lastError;
+        }
+        return false;
+    }
+    *output = best;
+    return true;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(settings);
+    Q_UNUSED(output);
+    if (error) {
+        *error = "未启用内置 PNG 优化器";
+    }
+    return false;
+#endif
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+struct PngOptimizeSettings {
+    int level;
+    int threads;
+};
+
+class PngOptimizer {
+public:
+    static bool isAvailable();
+    static bool optimize(
+        const QByteArray &source,
+        const PngOptimizeSettings &settings,
+        QByteArray *output,
+        QString *error
+    );
+};
@@ -0,0 +1,167 @@
+#include "PngQuantizer.h"
+
+#include "PngEncoder.h"
+
+#include <QImage>
+#include <QVector>
+
+#if defined(IMGCOMPRESS_HAS_LIBIMAGEQUANT)
+#include <libimagequant.h>
+#endif
+
+namespace {
+#if defined(IMGCOMPRESS_HAS_LIBIMAGEQUANT) && defined(IMGCOMPRESS_HAS_LIBPNG)
+class QuantizerContext {
+public:
+    QuantizerContext() : attributes(liq_attr_create()) {}
+    ~QuantizerContext() {
+        if (attributes) {
+            liq_attr_destroy(attributes);
+        }
+    }
+    QuantizerContext(const QuantizerContext &) = delete;
+    QuantizerContext &operator=(const QuantizerContext &) = delete;
+
+    liq_attr *get() const {
+        return attributes;
+    }
+
+private:
+    liq_attr *attributes;
+};
+
+liq_attr *threadAttributes() {
+    thread_local QuantizerContext context;
+    return context.get();
+}
+
+int paletteBitDepth(int colors) {
+    if (colors <= 2) {
+        return 1;
+    }
+    if (colors <= 4) {
+        return 2;
+    }
+    if (colors <= 16) {
+        return 4;
+    }
+    return 8;
+}
+#endif
+}
+
+bool PngQuantizer::isAvailable() {
+#if defined(IMGCOMPRESS_HAS_LIBIMAGEQUANT) && defined(IMGCOMPRESS_HAS_LIBPNG)
+    return true;
+#else
+    return false;
+#endif
+}
+
+PngQuantizer::Status PngQuantizer::quantize(
+    const QImage &source,
+    const PngQuantSettings &settings,
+    qint64 sizeLimit,
+    QByteArray *output,
+    QString *error
+) {
+#if defined(IMGCOMPRESS_HAS_LIBIMAGEQUANT) && defined(IMGCOMPRESS_HAS_LIBPNG)
+    liq_attr *attributes = threadAttributes();
+    if (!attributes || source.isNull() || !output) {
+        if (error) {
+            *error = "无法创建量化上下文";
+        }
+        return Status::Failed;
+    }
+    const liq_error qualitySet = liq_set_quality(attributes, settings.minQuality, settings.maxQuality);
+    const liq_error speedSet = liq_set_speed(attributes, settings.speed);
+    if (qualitySet != LIQ_OK || speedSet != LIQ_OK) {
+        if (error) {
+            *error = QString("量化参数无效(%1)").arg(static_cast<int>(qualitySet != LIQ_OK ? qualitySet : speedSet));
+        }
+        return Status::Failed;
+    }
+    const QImage image = source.convertToFormat(QImage::Format_RGBA8888);
+    const int width = image.width();
+    const int height = image.height();
+    QVector<void *> rows(height);
+    for (int y = 0; y < height; y += 1) {
+        rows[y] = const_cast<uchar *>(image.constScanLine(y));
+    }
+    liq_image *input = liq_image_create_rgba_rows(attributes, rows.data(), width, height, 0);
+    if (!input) {
+        if (error) {
+            *error = "无法创建量化图像";
+        }
+        return Status::Failed;
+    }
+    liq_result *result = nullptr;
+    const liq_error quantized = liq_image_quantize(input, attributes, &result);
+    if (quantized == LIQ_QUALITY_TOO_LOW) {
+        liq_image_destroy(input);
+        return Status::QualityTooLow;
+    }
+    if (quantized != LIQ_OK || !result) {
+        liq_image_destroy(input);
+        if (error) {
+            *error = QString("量化失败(%1)").arg(static_cast<int>(quantized));
+        }
+        return Status::Failed;
+    }
+    liq_set_dithering_level(result, 1.0f);
+    PngEncodeImage indexed{width, height, PngColorType::Palette, 8, QByteArray(), QByteArray(), QByteArray()};
+    indexed.pixels.resize(static_cast<qsizetype>(width) * height);
+    const liq_error remapped = liq_write_remapped_image(
+        result,
+        input,
+        indexed.pixels.data(),
+        static_cast<size_t>(indexed.pixels.size())
+    );
+    const liq_palette *palette = liq_get_palette(result);
+    if (remapped != LIQ_OK || !palette || palette->count == 0) {
+        liq_result_destroy(result);
+        liq_image_destroy(input);
+        if (error) {
+            *error = "量化重映射失败";
+        }
+        return Status::Failed;
+    }
+    const int colors = static_cast<int>(palette->count);
+    int transparentCount = 0;
+    indexed.palette.resize(colors * 3);
+    for (int i = 0; i < colors; i += 1) {
+        const liq_color &color = palette->entries[i];
+        indexed.palette[i * 3] = static_cast<char>(color.r);
+        indexed.palette[i * 3 + 1] = static_cast<char>(color.g);
+        indexed.palette[i * 3 + 2] = static_cast<char>(color.b);
+        if (color.a < 255) {
+            transparentCount = i + 1;
+        }
+    }
+    indexed.transparency.resize(transparentCount);
+    for (int i = 0; i < transparentCount; i += 1) {
+        indexed.transparency[i] = static_cast<char>(palette->entries[i].a);
+    }
+    indexed.bitDepth = paletteBitDepth(colors);
+    liq_result_destroy(result);
+    liq_image_destroy(input);
+    QByteArray encoded;
+    if (!PngEncoder::encode(indexed, {PngFilter::None, 9, PngStrategy::Default}, &encoded, error)) {
+        return Status::Failed;
+    }
+    if (sizeLimit > 0 && encoded.size() >= sizeLimit) {
+        return Status::NoGain;
+    }
+    *output = encoded;
+    return Status::Success;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(settings);
+    Q_UNUSED(sizeLimit);
+    Q_UNUSED(output);
+    if (error) {
+        *error = "未启用内置 pngquant 引擎";
+    }
+    return Status::Failed;
+#endif
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+class QImage;
+
+struct PngQuantSettings {
+    int minQuality;
+    int maxQuality;
+    int speed;
+};
+
+class PngQuantizer {
+public:
+    enum class Status {
+        Success,
+        QualityTooLow,
+        NoGain,
+        Failed
+    };
+
+    static bool isAvailable();
+    static Status quantize(
+        const QImage &image,
+        const PngQuantSettings &settings,
+        qint64 sizeLimit,
+        QByteArray *output,
+        QString *error
+    );
+};
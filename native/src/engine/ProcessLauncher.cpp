@@ -0,0 +1,917 @@
+#include "ProcessLauncher.h"
+
+#include "Task.h"
+
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtGlobal>
+
+#include <QFile>
+
+#include <memory>
+#include <utility>
+
+#if defined(Q_OS_WIN)
+#include <QFileInfo>
+#include <QProcess>
+
+#include <vector>
+#else
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(Q_OS_LINUX)
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+#include <thread>
+#endif
+
+extern char **environ;
+#endif
+
+namespace {
+const qsizetype kOutputLimit = 256 * 1024;
+
+class CpuStats {
+public:
+    void record(const QString &program, qint64 cpuMs, qint64 inputBytes) {
+        if (inputBytes <= 0) {
+            return;
+        }
+        QMutexLocker locker(&mutex);
+        Entry &entry = entries[program];
+        entry.totalMs += cpuMs;
+        entry.totalBytes += inputBytes;
+    }
+
+    qint64 estimate(const QString &program, qint64 inputBytes) {
+        QMutexLocker locker(&mutex);
+        const Entry entry = entries.value(program);
+        if (entry.totalBytes <= 0) {
+            return 0;
+        }
+        return static_cast<qint64>(static_cast<double>(entry.totalMs) * inputBytes / entry.totalBytes);
+    }
+
+private:
+    struct Entry {
+        qint64 totalMs = 0;
+        qint64 totalBytes = 0;
+    };
+
+    QMutex mutex;
+    QHash<QString, Entry> entries;
+};
+
+CpuStats &cpuStats() {
+    static CpuStats stats;
+    return stats;
+}
+
+int pipelineCode(const QVector<int> &codes) {
+    if (codes.isEmpty()) {
+        return -2;
+    }
+    if (codes.last() < -1) {
+        return codes.last();
+    }
+    for (const int code : codes) {
+        if (code != 0) {
+            return code;
+        }
+    }
+    return 0;
+}
+
+void discardSink(const QString &outputPath) {
+    if (!outputPath.isEmpty()) {
+        QFile::remove(outputPath);
+    }
+}
+
+#if defined(Q_OS_WIN)
+ProcessResult launch(
+    const QVector<ProcessCommand> &commands,
+    const QByteArray &input,
+    const QString &outputPath,
+    qint64 byteLimit,
+    int timeoutMs
+) {
+    std::vector<std::unique_ptr<QProcess>> processes;
+    for (const ProcessCommand &command : commands) {
+        auto process = std::make_unique<QProcess>();
+        process->setProgram(command.program);
+        process->setArguments(command.args);
+        processes.push_back(std::move(process));
+    }
+    for (size_t i = 0; i + 1 < processes.size(); i += 1) {
+        processes[i]->setStandardOutputProcess(processes[i + 1].get());
+    }
+    if (outputPath.isEmpty()) {
+        processes.back()->setProcessChannelMode(QProcess::MergedChannels);
+    } else {
+        processes.back()->setStandardOutputFile(outputPath, QIODevice::Truncate);
+    }
+    for (auto &process : processes) {
+        process->start();
+    }
+    for (auto &process : processes) {
+        if (!process->waitForStarted(timeoutMs)) {
+            const QByteArray error = process->errorString().toUtf8();
+            for (auto &other : processes) {
+                other->kill();
+                other->waitForFinished(2000);
+            }
+            discardSink(outputPath);
+            return {-1, error, 0};
+        }
+    }
+    if (!input.isEmpty()) {
+        processes.front()->write(input);
+    }
+    processes.front()->closeWriteChannel();
+    const QDeadlineTimer deadline(timeoutMs);
+    QVector<int> codes;
+    for (auto &process : processes) {
+        if (!process->waitForFinished(static_cast<int>(qMax<qint64>(1, deadline.remainingTime())))) {
+            for (auto &other : processes) {
+                other->kill();
+                other->waitForFinished(2000);
+            }
+            codes = {-2};
+            break;
+        }
+        codes.append(process->exitStatus() == QProcess::NormalExit ? process->exitCode() : -1);
+    }
+    QByteArray output;
+    for (size_t i = 0; i + 1 < processes.size(); i += 1) {
+        output += processes[i]->readAllStandardError();
+    }
+    if (outputPath.isEmpty()) {
+        output += processes.back()->readAllStandardOutput();
+    } else {
+        output += processes.back()->readAllStandardError();
+    }
+    int code = pipelineCode(codes);
+    if (code == 0 && byteLimit > 0 && QFileInfo(outputPath).size() > byteLimit) {
+        code = -3;
+    }
+    if (code != 0) {
+        discardSink(outputPath);
+    }
+    return {code, output.left(kOutputLimit), 0};
+}
+#else
+const int kPollSliceMs = 20;
+
+bool makePipe(int fds[2]) {
+#if defined(Q_OS_LINUX)
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+void closeFd(int *fd) {
+    if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#if defined(F_SETNOSIGPIPE)
+    fcntl(fd, F_SETNOSIGPIPE, 1);
+#endif
+}
+
+int openExitFd(pid_t pid) {
+#if defined(Q_OS_LINUX) && defined(SYS_pidfd_open)
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    Q_UNUSED(pid);
+    return -1;
+#endif
+}
+
+int spawnChild(const ProcessCommand &command, int inputFd, int outputFd, int errorFd, pid_t *pid) {
+    std::vector<QByteArray> encoded;
+    encoded.reserve(static_cast<size_t>(command.args.size()) + 1);
+    encoded.push_back(QFile::encodeName(command.program));
+    for (const QString &arg : command.args) {
+        encoded.push_back(QFile::encodeName(arg));
+    }
+    std::vector<char *> argv;
+    argv.reserve(encoded.size() + 1);
+    for (QByteArray &item : encoded) {
+        argv.push_back(item.data());
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (inputFd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, inputFd, STDIN_FILENO);
+    } else {
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    }
+    posix_spawn_file_actions_adddup2(&actions, outputFd, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, errorFd, STDERR_FILENO);
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#if defined(Q_OS_MACOS)
+    flags |= POSIX_SPAWN_CLOEXEC_DEFAULT;
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+    const int rc = posix_spawn(pid, argv[0], &actions, &attr, argv.data(), environ);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return rc;
+}
+
+bool reapStage(pid_t pid, int options, int *code, qint64 *cpuMs) {
+    int status = 0;
+    rusage usage{};
+    pid_t result = -1;
+    do {
+        result = wait4(pid, &status, options, &usage);
+    } while (result == -1 && errno == EINTR);
+    if (result == 0) {
+        return false;
+    }
+    *code = result == pid && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    if (result == pid) {
+        *cpuMs += (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000LL
+            + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+    }
+    return true;
+}
+
+struct StreamState {
+    int sinkFd;
+    qint64 limit;
+    qint64 written;
+    bool overflow;
+    bool failed;
+};
+
+bool drainOutput(int fd, QByteArray *output) {
+    char buffer[16384];
+    for (;;) {
+        const ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count > 0) {
+            const qsizetype room = kOutputLimit - output->size();
+            if (room > 0) {
+                output->append(buffer, qMin<qsizetype>(room, count));
+            }
+            continue;
+        }
+        if (count == 0) {
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+bool feedInput(int fd, const QByteArray &input, qsizetype *offset) {
+    while (*offset < input.size()) {
+        const ssize_t count = write(fd, input.constData() + *offset, static_cast<size_t>(input.size() - *offset));
+        if (count > 0) {
+            *offset += count;
+            continue;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    return false;
+}
+
+bool writeAll(int fd, const char *data, qsizetype size) {
+    while (size > 0) {
+        const ssize_t count = write(fd, data, static_cast<size_t>(size));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool pumpStream(int fd, StreamState *stream) {
+    char buffer[65536];
+    for (;;) {
+        const ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count > 0) {
+            stream->written += count;
+            if (stream->limit > 0 && stream->written > stream->limit) {
+                stream->overflow = true;
+                return false;
+            }
+            if (!writeAll(stream->sinkFd, buffer, count)) {
+                stream->failed = true;
+                return false;
+            }
+            continue;
+        }
+        if (count == 0) {
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+#if defined(Q_OS_LINUX)
+class SigpipeBlock {
+public:
+    SigpipeBlock() {
+        sigemptyset(&pipeSet);
+        sigaddset(&pipeSet, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipeSet, &previous);
+    }
+
+    ~SigpipeBlock() {
+        const timespec zero{0, 0};
+        while (sigtimedwait(&pipeSet, nullptr, &zero) > 0) {
+        }
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    }
+
+private:
+    sigset_t pipeSet;
+    sigset_t previous;
+};
+#endif
+#endif
+}
+
+#if defined(Q_OS_WIN)
+struct ProcessOperation {};
+#else
+struct ProcessOperation {
+    QVector<pid_t> pids;
+    QVector<int> exitFds;
+    QVector<int> codes;
+    QVector<bool> exited;
+    int running;
+    int outputFd;
+    int inputFd;
+    QByteArray input;
+    qsizetype inputOffset;
+    int streamFd;
+    StreamState stream;
+    bool stopped;
+    QString outputPath;
+    QDeadlineTimer deadline;
+    QByteArray output;
+    qint64 cpuMs;
+    ProcessResult result;
+    int epollFd;
+    std::coroutine_handle<> caller;
+    QThreadPool *executor;
+};
+
+namespace {
+void releaseFd(ProcessOperation *operation, int *fd) {
+#if defined(Q_OS_LINUX)
+    if (*fd >= 0 && operation->epollFd >= 0) {
+        epoll_ctl(operation->epollFd, EPOLL_CTL_DEL, *fd, nullptr);
+    }
+#else
+    Q_UNUSED(operation);
+#endif
+    closeFd(fd);
+}
+
+void abortStages(ProcessOperation *operation) {
+    for (int i = 0; i < operation->pids.size(); i += 1) {
+        if (operation->exited[i]) {
+            continue;
+        }
+        kill(operation->pids[i], SIGKILL);
+        reapStage(operation->pids[i], 0, &operation->codes[i], &operation->cpuMs);
+        operation->codes[i] = -2;
+        operation->exited[i] = true;
+        operation->running -= 1;
+        releaseFd(operation, &operation->exitFds[i]);
+    }
+}
+
+void stageExited(ProcessOperation *operation, int stage) {
+    operation->exited[stage] = true;
+    operation->running -= 1;
+    releaseFd(operation, &operation->exitFds[stage]);
+    if (stage != operation->pids.size() - 1) {
+        return;
+    }
+    if (operation->outputFd >= 0) {
+        drainOutput(operation->outputFd, &operation->output);
+    }
+    if (operation->streamFd >= 0) {
+        pumpStream(operation->streamFd, &operation->stream);
+    }
+    if (operation->stream.overflow) {
+        operation->codes[stage] = -3;
+    } else if (operation->stream.failed) {
+        operation->codes[stage] = -1;
+    }
+    if (operation->codes[stage] < -1) {
+        abortStages(operation);
+    }
+}
+
+void stepOperation(ProcessOperation *operation) {
+    if (operation->inputFd >= 0 && !feedInput(operation->inputFd, operation->input, &operation->inputOffset)) {
+        releaseFd(operation, &operation->inputFd);
+    }
+    if (operation->outputFd >= 0 && !drainOutput(operation->outputFd, &operation->output)) {
+        releaseFd(operation, &operation->outputFd);
+    }
+    if (operation->streamFd >= 0) {
+        if (!pumpStream(operation->streamFd, &operation->stream)) {
+            releaseFd(operation, &operation->streamFd);
+        }
+        if (!operation->stopped && !operation->exited.last() && (operation->stream.overflow || operation->stream.failed)) {
+            kill(operation->pids.last(), SIGKILL);
+            operation->stopped = true;
+        }
+    }
+    for (int i = 0; i < operation->pids.size(); i += 1) {
+        if (!operation->exited[i] && reapStage(operation->pids[i], WNOHANG, &operation->codes[i], &operation->cpuMs)) {
+            stageExited(operation, i);
+        }
+    }
+}
+
+void finishOperation(ProcessOperation *operation) {
+    if (operation->outputFd >= 0) {
+        drainOutput(operation->outputFd, &operation->output);
+    }
+    releaseFd(operation, &operation->outputFd);
+    releaseFd(operation, &operation->inputFd);
+    releaseFd(operation, &operation->streamFd);
+    for (int &fd : operation->exitFds) {
+        releaseFd(operation, &fd);
+    }
+    closeFd(&operation->stream.sinkFd);
+    const int code = pipelineCode(operation->codes);
+    if (code != 0) {
+        discardSink(operation->outputPath);
+    }
+    operation->result = {code, operation->output, operation->cpuMs};
+}
+
+void waitOperation(ProcessOperation *operation) {
+#if defined(Q_OS_LINUX)
+    const SigpipeBlock sigpipe;
+#endif
+    stepOperation(operation);
+    while (operation->running > 0) {
+        const qint64 remaining = operation->deadline.remainingTime();
+        if (remaining == 0) {
+            abortStages(operation);
+            break;
+        }
+        std::vector<pollfd> fds;
+        if (operation->outputFd >= 0) {
+            fds.push_back({operation->outputFd, POLLIN, 0});
+        }
+        if (operation->streamFd >= 0) {
+            fds.push_back({operation->streamFd, POLLIN, 0});
+        }
+        if (operation->inputFd >= 0) {
+            fds.push_back({operation->inputFd, POLLOUT, 0});
+        }
+        bool sliced = false;
+        for (int i = 0; i < operation->pids.size(); i += 1) {
+            if (operation->exited[i]) {
+                continue;
+            }
+            if (operation->exitFds[i] >= 0) {
+                fds.push_back({operation->exitFds[i], POLLIN, 0});
+            } else {
+                sliced = true;
+            }
+        }
+        int wait = remaining < 0 ? -1 : static_cast<int>(qMin<qint64>(remaining, INT_MAX));
+        if (sliced) {
+            wait = wait < 0 ? kPollSliceMs : qMin(wait, kPollSliceMs);
+        }
+        poll(fds.data(), static_cast<nfds_t>(fds.size()), wait);
+        stepOperation(operation);
+    }
+}
+
+ProcessOperation *spawnOperation(
+    const QVector<ProcessCommand> &commands,
+    const QByteArray &input,
+    const QString &outputPath,
+    qint64 byteLimit,
+    int timeoutMs,
+    ProcessResult *failure
+) {
+    int sinkFd = -1;
+    if (!outputPath.isEmpty()) {
+        sinkFd = open(QFile::encodeName(outputPath).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (sinkFd < 0) {
+            *failure = {-1, qt_error_string(errno).toUtf8(), 0};
+            return nullptr;
+        }
+    }
+    int captureFds[2] = {-1, -1};
+    int inputFds[2] = {-1, -1};
+    int streamFds[2] = {-1, -1};
+    if (!makePipe(captureFds)
+        || (!input.isEmpty() && !makePipe(inputFds))
+        || (sinkFd >= 0 && !makePipe(streamFds))) {
+        const int error = errno;
+        closeFd(&captureFds[0]);
+        closeFd(&captureFds[1]);
+        closeFd(&inputFds[0]);
+        closeFd(&inputFds[1]);
+        closeFd(&sinkFd);
+        discardSink(outputPath);
+        *failure = {-1, qt_error_string(error).toUtf8(), 0};
+        return nullptr;
+    }
+    const int lastOutput = sinkFd >= 0 ? streamFds[1] : captureFds[1];
+    QVector<pid_t> pids;
+    int stageInput = inputFds[0];
+    int error = 0;
+    for (int i = 0; i < commands.size() && error == 0; i += 1) {
+        const bool last = i == commands.size() - 1;
+        int linkFds[2] = {-1, -1};
+        if (!last && !makePipe(linkFds)) {
+            error = errno;
+            break;
+        }
+        pid_t pid = -1;
+        error = spawnChild(commands[i], stageInput, last ? lastOutput : linkFds[1], captureFds[1], &pid);
+        if (error == 0) {
+            pids.append(pid);
+        }
+        closeFd(&stageInput);
+        closeFd(&linkFds[1]);
+        stageInput = linkFds[0];
+    }
+    closeFd(&stageInput);
+    closeFd(&captureFds[1]);
+    closeFd(&streamFds[1]);
+    if (error != 0) {
+        closeFd(&inputFds[1]);
+        closeFd(&captureFds[0]);
+        closeFd(&streamFds[0]);
+        qint64 cpuMs = 0;
+        for (const pid_t pid : pids) {
+            int code = -1;
+            kill(pid, SIGKILL);
+            reapStage(pid, 0, &code, &cpuMs);
+        }
+        closeFd(&sinkFd);
+        discardSink(outputPath);
+        *failure = {-1, qt_error_string(error).toUtf8(), 0};
+        return nullptr;
+    }
+    setNonBlocking(captureFds[0]);
+    if (inputFds[1] >= 0) {
+        setNonBlocking(inputFds[1]);
+    }
+    if (streamFds[0] >= 0) {
+        setNonBlocking(streamFds[0]);
+    }
+    auto *operation = new ProcessOperation;
+    operation->pids = pids;
+    for (const pid_t pid : pids) {
+        operation->exitFds.append(openExitFd(pid));
+    }
+    operation->codes = QVector<int>(pids.size(), -1);
+    operation->exited = QVector<bool>(pids.size(), false);
+    operation->running = static_cast<int>(pids.size());
+    operation->outputFd = captureFds[0];
+    operation->inputFd = inputFds[1];
+    operation->input = input;
+    operation->inputOffset = 0;
+    operation->streamFd = streamFds[0];
+    operation->stream = {sinkFd, byteLimit, 0, false, false};
+    operation->stopped = false;
+    operation->outputPath = outputPath;
+    operation->deadline = QDeadlineTimer(timeoutMs);
+    operation->cpuMs = 0;
+    operation->result = {-1, QByteArray(), 0};
+    operation->epollFd = -1;
+    operation->executor = nullptr;
+    return operation;
+}
+
+ProcessResult launch(
+    const QVector<ProcessCommand> &commands,
+    const QByteArray &input,
+    const QString &outputPath,
+    qint64 byteLimit,
+    int timeoutMs
+) {
+    ProcessResult failure{-1, QByteArray(), 0};
+    const std::unique_ptr<ProcessOperation> operation(spawnOperation(commands, input, outputPath, byteLimit, timeoutMs, &failure));
+    if (!operation) {
+        return failure;
+    }
+    waitOperation(operation.get());
+    finishOperation(operation.get());
+    return operation->result;
+}
+
+#if defined(Q_OS_LINUX)
+bool watchable(const ProcessOperation *operation) {
+    for (const int fd : operation->exitFds) {
+        if (fd < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class ProcessReactor {
+public:
+    static ProcessReactor *instance() {
+        static ProcessReactor *reactor = create();
+        return reactor;
+    }
+
+    void watch(ProcessOperation *operation) {
+        {
+            QMutexLocker locker(&mutex);
+            incoming.append(operation);
+        }
+        const quint64 one = 1;
+        while (write(wakeFd, &one, sizeof(one)) < 0 && errno == EINTR) {
+        }
+    }
+
+private:
+    ProcessReactor(int epoll, int wake) : epollFd(epoll), wakeFd(wake) {}
+
+    static ProcessReactor *create() {
+        int epoll = epoll_create1(EPOLL_CLOEXEC);
+        int wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        if (epoll < 0 || wake < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, wake, &event) != 0) {
+            closeFd(&epoll);
+            closeFd(&wake);
+            return nullptr;
+        }
+        auto *reactor = new ProcessReactor(epoll, wake);
+        std::thread([reactor]() {
+            reactor->loop();
+        }).detach();
+        return reactor;
+    }
+
+    void add(ProcessOperation *operation) {
+        operation->epollFd = epollFd;
+        const auto watchFd = [this, operation](int fd, quint32 events) {
+            if (fd < 0) {
+                return;
+            }
+            epoll_event event{};
+            event.events = events;
+            event.data.ptr = operation;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        };
+        watchFd(operation->outputFd, EPOLLIN);
+        watchFd(operation->streamFd, EPOLLIN);
+        watchFd(operation->inputFd, EPOLLOUT);
+        for (const int fd : operation->exitFds) {
+            watchFd(fd, EPOLLIN);
+        }
+        operations.append(operation);
+    }
+
+    int nextTimeout() const {
+        qint64 timeout = -1;
+        for (const ProcessOperation *operation : operations) {
+            const qint64 remaining = operation->deadline.remainingTime();
+            if (remaining >= 0 && (timeout < 0 || remaining < timeout)) {
+                timeout = remaining;
+            }
+        }
+        return static_cast<int>(qMin<qint64>(timeout, INT_MAX));
+    }
+
+    void loop() {
+        epoll_event events[64];
+        for (;;) {
+            const int count = epoll_wait(epollFd, events, 64, nextTimeout());
+            QVector<ProcessOperation *> touched;
+            for (int i = 0; i < count; i += 1) {
+                auto *operation = static_cast<ProcessOperation *>(events[i].data.ptr);
+                if (operation) {
+                    if (!touched.contains(operation)) {
+                        touched.append(operation);
+                    }
+                    continue;
+                }
+                quint64 value = 0;
+                while (read(wakeFd, &value, sizeof(value)) > 0) {
+                }
+                QVector<ProcessOperation *> added;
+                {
+                    QMutexLocker locker(&mutex);
+                    added.swap(incoming);
+                }
+                for (ProcessOperation *next : added) {
+                    add(next);
+                    touched.append(next);
+                }
+            }
+            const SigpipeBlock sigpipe;
+            for (ProcessOperation *operation : touched) {
+                stepOperation(operation);
+            }
+            for (int i = 0; i < operations.size();) {
+                ProcessOperation *operation = operations[i];
+                if (operation->running > 0 && operation->deadline.hasExpired()) {
+                    abortStages(operation);
+                }
+                if (operation->running > 0) {
+                    i += 1;
+                    continue;
+                }
+                operations.removeAt(i);
+                finishOperation(operation);
+                operation->epollFd = -1;
+                resumeTask(operation->caller, operation->executor);
+            }
+        }
+    }
+
+    int epollFd;
+    int wakeFd;
+    QMutex mutex;
+    QVector<ProcessOperation *> incoming;
+    QVector<ProcessOperation *> operations;
+};
+#endif
+}
+#endif
+
+ProcessAwaiter::ProcessAwaiter(const ProcessResult &finished) : operation(nullptr), result(finished) {}
+
+ProcessAwaiter::ProcessAwaiter(ProcessOperation *running) : operation(running), result{-1, QByteArray(), 0} {}
+
+ProcessAwaiter::ProcessAwaiter(ProcessAwaiter &&other) noexcept
+    : operation(std::exchange(other.operation, nullptr)),
+      result(other.result) {}
+
+ProcessAwaiter::~ProcessAwaiter() {
+#if !defined(Q_OS_WIN)
+    if (operation) {
+        waitOperation(operation);
+        finishOperation(operation);
+    }
+#endif
+    delete operation;
+}
+
+bool ProcessAwaiter::await_ready() const noexcept {
+    return !operation;
+}
+
+void ProcessAwaiter::watch(std::coroutine_handle<> caller, QThreadPool *executor) {
+#if defined(Q_OS_LINUX)
+    operation->caller = caller;
+    operation->executor = executor;
+    ProcessReactor::instance()->watch(operation);
+#else
+    Q_UNUSED(caller);
+    Q_UNUSED(executor);
+#endif
+}
+
+ProcessResult ProcessAwaiter::await_resume() {
+#if !defined(Q_OS_WIN)
+    if (operation) {
+        result = operation->result;
+        delete operation;
+        operation = nullptr;
+    }
+#endif
+    return result;
+}
+
+ProcessResult ProcessLauncher::run(const QString &program, const QStringList &args, int timeoutMs) {
+    return runPipeline({{program, args}}, QByteArray(), timeoutMs);
+}
+
+ProcessResult ProcessLauncher::runPipeline(
+    const QVector<ProcessCommand> &commands,
+    const QByteArray &input,
+    int timeoutMs
+) {
+    if (commands.isEmpty()) {
+        return {-1, QByteArray(), 0};
+    }
+    return launch(commands, input, QString(), 0, timeoutMs);
+}
+
+ProcessResult ProcessLauncher::runToFile(
+    const QVector<ProcessCommand> &commands,
+    const QByteArray &input,
+    const QString &outputPath,
+    qint64 byteLimit,
+    int timeoutMs
+) {
+    if (commands.isEmpty()) {
+        return {-1, QByteArray(), 0};
+    }
+    return launch(commands, input, outputPath, byteLimit, timeoutMs);
+}
+
+ProcessAwaiter ProcessLauncher::start(const QString &program, const QStringList &args, int timeoutMs) {
+    return startPipeline({{program, args}}, QByteArray(), timeoutMs);
+}
+
+ProcessAwaiter ProcessLauncher::startPipeline(
+    const QVector<ProcessCommand> &commands,
+    const QByteArray &input,
+    int timeoutMs
+) {
+    return startToFile(commands, input, QString(), 0, timeoutMs);
+}
+
+ProcessAwaiter ProcessLauncher::startToFile(
+    const QVector<ProcessCommand> &commands,
+    const QByteArray &input,
+    const QString &outputPath,
+    qint64 byteLimit,
+    int timeoutMs
+) {
+    if (commands.isEmpty()) {
+        return ProcessAwaiter(ProcessResult{-1, QByteArray(), 0});
+    }
+#if defined(Q_OS_LINUX)
+    ProcessResult failure{-1, QByteArray(), 0};
+    ProcessOperation *operation = spawnOperation(commands, input, outputPath, byteLimit, timeoutMs, &failure);
+    if (!operation) {
+        return ProcessAwaiter(failure);
+    }
+    if (watchable(operation) && ProcessReactor::instance()) {
+        return ProcessAwaiter(operation);
+    }
+    waitOperation(operation);
+    finishOperation(operation);
+    const ProcessResult finished = operation->result;
+    delete operation;
+    return ProcessAwaiter(finished);
+#else
+    return ProcessAwaiter(launch(commands, input, outputPath, byteLimit, timeoutMs));
+#endif
+}
+
+void ProcessLauncher::recordCpu(const QString &program, qint64 cpuMs, qint64 inputBytes) {
+    cpuStats().record(program, cpuMs, inputBytes);
+}
+
+qint64 ProcessLauncher::estimateCpuMs(const QString &program, qint64 inputBytes) {
+    return cpuStats().estimate(program, inputBytes);
+}
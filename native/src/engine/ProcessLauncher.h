@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <coroutine>
+
+class QThreadPool;
+struct ProcessOperation;
+
+struct ProcessCommand {
+    QString program;
+    QStringList args;
+};
+
+struct ProcessResult {
+    int code;
+    QByteArray output;
+    qint64 cpuMs;
+};
+
+class ProcessAwaiter {
+public:
+    explicit ProcessAwaiter(const ProcessResult &finished);
+    explicit ProcessAwaiter(ProcessOperation *running);
+    ProcessAwaiter(ProcessAwaiter &&other) noexcept;
+    ~ProcessAwaiter();
+
+    ProcessAwaiter(const ProcessAwaiter &) = delete;
+    ProcessAwaiter &operator=(const ProcessAwaiter &) = delete;
+
+    bool await_ready() const noexcept;
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> caller) {
+        watch(caller, caller.promise().executor);
+    }
+
+    ProcessResult await_resume();
+
+private:
+    void watch(std::coroutine_handle<> caller, QThreadPool *executor);
+
+    ProcessOperation *operation;
+    ProcessResult result;
+};
+
+class ProcessLauncher {
+public:
+    static ProcessResult run(const QString &program, const QStringList &args, int timeoutMs);
+    static ProcessResult runPipeline(const QVector<ProcessCommand> &commands, const QByteArray &input, int timeoutMs);
+    static ProcessResult runToFile(
+        const QVector<ProcessCommand> &commands,
+        const QByteArray &input,
+        const QString &outputPath,
+        qint64 byteLimit,
+        int timeoutMs
+    );
+    static ProcessAwaiter start(const QString &program, const QStringList &args, int timeoutMs);
+    static ProcessAwaiter startPipeline(const QVector<ProcessCommand> &commands, const QByteArray &input, int timeoutMs);
+    static ProcessAwaiter startToFile(
+        const QVector<ProcessCommand> &commands,
+        const QByteArray &input,
+        const QString &outputPath,
+        qint64 byteLimit,
+        int timeoutMs
+    );
+    static void recordCpu(const QString &program, qint64 cpuMs, qint64 inputBytes);
+    static qint64 estimateCpuMs(const QString &program, qint64 inputBytes);
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <QThreadPool>
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+inline void resumeTask(std::coroutine_handle<> coroutine, QThreadPool *executor) {
+    if (executor) {
+        executor->start([coroutine]() {
+            coroutine.resume();
+        });
+    } else {
+        coroutine.resume();
+    }
+}
+
+class TaskPromise {
+public:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coroutine) noexcept {
+            TaskPromise &promise = coroutine.promise();
+            if (promise.continuation) {
+                return promise.continuation;
+            }
+            if (promise.detached) {
+                coroutine.destroy();
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    TaskPromise() : executor(nullptr), detached(false) {}
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+
+    void unhandled_exception() const noexcept {
+        std::terminate();
+    }
+
+    QThreadPool *executor;
+    std::coroutine_handle<> continuation;
+    bool detached;
+};
+
+template <typename T>
+class Task {
+public:
+    struct promise_type : TaskPromise {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        void return_value(T result) {
+            value.emplace(std::move(result));
+        }
+
+        std::optional<T> value;
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> coroutine) : handle(coroutine) {}
+
+    Task(Task &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> caller) noexcept {
+        handle.promise().continuation = caller;
+        handle.promise().executor = caller.promise().executor;
+        return handle;
+    }
+
+    T await_resume() {
+        return std::move(*handle.promise().value);
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <>
+class Task<void> {
+public:
+    struct promise_type : TaskPromise {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        void return_void() const noexcept {}
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> coroutine) : handle(coroutine) {}
+
+    Task(Task &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    static void start(QThreadPool *pool, Task task) {
+        const std::coroutine_handle<promise_type> coroutine = std::exchange(task.handle, {});
+        coroutine.promise().executor = pool;
+        coroutine.promise().detached = true;
+        resumeTask(coroutine, pool);
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> caller) noexcept {
+        handle.promise().continuation = caller;
+        handle.promise().executor = caller.promise().executor;
+        return handle;
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
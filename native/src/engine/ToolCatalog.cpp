@@ -0,0 +1,268 @@
+#include "ToolCatalog.h"
+
+#include "ProcessLauncher.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QSysInfo>
+#include <QWriteLocker>
+
+namespace {
+const int kProbeTimeoutMs = 5000;
+
+const QStringList kKnownTools = {
+    "jpegtran",
+    "cjpeg",
+    "mozjpeg",
+    "jpegoptim",
+    "pngquant",
+    "oxipng",
+    "optipng",
+    "gifsicle",
+    "cwebp",
+    "dwebp"
+};
+
+QString detectPlatform() {
+    const QString product = QSysInfo::productType().toLower();
+    if (product == "osx" || product == "macos" || product == "darwin") {
+        return "macos";
+    }
+    if (product == "windows" || product == "win") {
+        return "windows";
+    }
+    if (product == "linux") {
+        return "linux";
+    }
+    return product;
+}
+
+QString detectArch() {
+    const QString arch = QSysInfo::currentCpuArchitecture().toLower();
+    if (arch.contains("arm64") || arch.contains("aarch64")) {
+        return "arm64";
+    }
+    if (arch.contains("x86_64") || arch.contains("amd64")) {
+        return "x64";
+    }
+    return arch;
+}
+
+QStringList collectVendorBases(const QDir &startDir, const QString &platformKey, const QString &archKey) {
+    QStringList bases;
+    QDir current = startDir;
+    for (int depth = 0; depth < 8; ++depth) {
+        const QString vendorRoot = current.filePath("vendor");
+        if (QDir(vendorRoot).exists()) {
+            bases << vendorRoot
+                  << QDir(vendorRoot).filePath(QString("%1/%2").arg(platformKey, archKey))
+                  << QDir(vendorRoot).filePath(QString("%1").arg(platformKey));
+        }
+        if (!current.cdUp()) {
+            break;
+        }
+    }
+    return bases;
+}
+
+QStringList searchDirs() {
+    const QString appDir = QCoreApplication::applicationDirPath();
+    const QString platformKey = ToolCatalog::platformKey();
+    const QString archKey = ToolCatalog::archKey();
+    QStringList baseDirs = {
+        appDir,
+        QDir(appDir).filePath("vendor"),
+        QDir(appDir).filePath(QString("vendor/%1/%2").arg(platformKey, archKey)),
+        QDir(appDir).filePath(QString("vendor/%1").arg(platformKey)),
+        QDir(appDir).filePath("../Resources"),
+        QDir(appDir).filePath("../Resources/vendor"),
+        QDir(appDir).filePath(QString("../Resources/vendor/%1/%2").arg(platformKey, archKey)),
+        QDir(appDir).filePath(QString("../Resources/vendor/%1").arg(platformKey)),
+        QDir(appDir).filePath("../MacOS"),
+        QDir(appDir).filePath("../MacOS/vendor"),
+        QDir(appDir).filePath(QString("../MacOS/vendor/%1/%2").arg(platformKey, archKey)),
+        QDir(appDir).filePath(QString("../MacOS/vendor/%1").arg(platformKey)),
+        QDir(appDir).filePath("../Frameworks"),
+        QDir(appDir).filePath("../Frameworks/vendor"),
+        QDir(appDir).filePath(QString("../Frameworks/vendor/%1/%2").arg(platformKey, archKey)),
+        QDir(appDir).filePath(QString("../Frameworks/vendor/%1").arg(platformKey)),
+    };
+    baseDirs += collectVendorBases(QDir(appDir), platformKey, archKey);
+    return baseDirs;
+}
+
+QString firstLine(const QByteArray &output) {
+    return QString::fromUtf8(output).section('\n', 0, 0).trimmed();
+}
+
+ToolInfo probe(const QString &name, const QString &path) {
+    const bool dashVersion = name == "cjpeg" || name == "mozjpeg" || name == "jpegtran"
+        || name == "cwebp" || name == "dwebp";
+    const ProcessResult version = ProcessLauncher::run(path, {dashVersion ? "-version" : "--version"}, kProbeTimeoutMs);
+    ToolInfo info{path, version.code >= 0 ? firstLine(version.output) : QString(), false};
+    if (name == "oxipng") {
+        info.threads = ProcessLauncher::run(path, {"--help"}, kProbeTimeoutMs).output.contains("--threads");
+    } else if (name == "cwebp") {
+        info.threads = ProcessLauncher::run(path, {"-longhelp"}, kProbeTimeoutMs).output.contains("-mt");
+    }
+    return info;
+}
+
+struct Entry {
+    int rank;
+    ToolInfo info;
+    bool probed;
+    qint64 size;
+    qint64 mtimeMs;
+};
+
+bool sameBinary(const Entry &left, const Entry &right) {
+    return left.info.path == right.info.path && left.size == right.size && left.mtimeMs == right.mtimeMs;
+}
+
+class Catalog {
+public:
+    QString find(const QStringList &names) {
+        {
+            QReadLocker locker(&lock);
+            QString path;
+            if (loaded && pick(names, &path)) {
+                return path;
+            }
+        }
+        QWriteLocker locker(&lock);
+        load();
+        for (const QString &name : names) {
+            if (!entries.contains(name)) {
+                entries.insert(name, resolve(name));
+            }
+        }
+        QString path;
+        pick(names, &path);
+        return path;
+    }
+
+    ToolInfo info(const QString &name) {
+        const QString path = find({name});
+        if (path.isEmpty()) {
+            return {QString(), QString(), false};
+        }
+        Entry seen{-1, {path, QString(), false}, false, -1, -1};
+        {
+            QReadLocker locker(&lock);
+            const auto it = entries.constFind(name);
+            if (it != entries.constEnd() && it->probed) {
+                return it->info;
+            }
+            if (it != entries.constEnd()) {
+                seen = *it;
+            }
+        }
+        const ToolInfo probed = probe(name, path);
+        QWriteLocker locker(&lock);
+        const auto it = entries.find(name);
+        if (it != entries.end() && sameBinary(*it, seen)) {
+            it->info = probed;
+            it->probed = true;
+        }
+        return probed;
+    }
+
+    void refresh() {
+        QWriteLocker locker(&lock);
+        dirs = searchDirs();
+        loaded = true;
+        QStringList names = entries.keys();
+        for (const QString &name : kKnownTools) {
+            if (!names.contains(name)) {
+                names.append(name);
+            }
+        }
+        for (const QString &name : names) {
+            const Entry resolved = resolve(name);
+            const auto it = entries.constFind(name);
+            if (it == entries.constEnd() || !sameBinary(*it, resolved)) {
+                entries.insert(name, resolved);
+            }
+        }
+    }
+
+private:
+    void load() {
+        if (loaded) {
+            return;
+        }
+        dirs = searchDirs();
+        loaded = true;
+        for (const QString &name : kKnownTools) {
+            entries.insert(name, resolve(name));
+        }
+    }
+
+    Entry resolve(const QString &name) const {
+        for (int i = 0; i < dirs.size(); i += 1) {
+            const QFileInfo candidate(QDir(dirs[i]).filePath(name));
+            if (candidate.exists()) {
+                return {i, {candidate.filePath(), QString(), false}, false, candidate.size(), candidate.lastModified().toMSecsSinceEpoch()};
+            }
+            const QFileInfo exeCandidate(QDir(dirs[i]).filePath(name + ".exe"));
+            if (exeCandidate.exists()) {
+                return {i, {exeCandidate.filePath(), QString(), false}, false, exeCandidate.size(), exeCandidate.lastModified().toMSecsSinceEpoch()};
+            }
+        }
+        return {-1, {QString(), QString(), false}, false, -1, -1};
+    }
+
+    bool pick(const QStringList &names, QString *path) const {
+        int bestRank = -1;
+        for (const QString &name : names) {
+            const auto it = entries.constFind(name);
+            if (it == entries.constEnd()) {
+                return false;
+            }
+            if (it->rank >= 0 && (bestRank < 0 || it->rank < bestRank)) {
+                bestRank = it->rank;
+                *path = it->info.path;
+            }
+        }
+        return true;
+    }
+
+    QReadWriteLock lock;
+    QStringList dirs;
+    QHash<QString, Entry> entries;
+    bool loaded = false;
+};
+
+Catalog &catalog() {
+    static Catalog instance;
+    return instance;
+}
+}
+
+QString ToolCatalog::find(const QStringList &names) {
+    return catalog().find(names);
+}
+
+ToolInfo ToolCatalog::info(const QString &name) {
+    return catalog().info(name);
+}
+
+QString ToolCatalog::platformKey() {
+    static const QString key = detectPlatform();
+    return key;
+}
+
+QString ToolCatalog::archKey() {
+    static const QString key = detectArch();
+    return key;
+}
+
+void ToolCatalog::refresh() {
+    catalog().refresh();
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+struct ToolInfo {
+    QString path;
+    QString version;
+    bool threads;
+};
+
+class ToolCatalog {
+public:
+    static QString find(const QStringList &names);
+    static ToolInfo info(const QString &name);
+    static QString platformKey();
+    static QString archKey();
+    static void refresh();
+};
@@ -0,0 +1,174 @@
+#include "WebpCodec.h"
+
+#include <QImage>
+
+#if defined(IMGCOMPRESS_HAS_LIBWEBP)
+#include <webp/decode.h>
+#include <webp/encode.h>
+#endif
+
+namespace {
+#if defined(IMGCOMPRESS_HAS_LIBWEBP)
+struct CappedWriter {
+    QByteArray *buffer;
+    qint64 limit;
+    bool exceeded;
+};
+
+int writeCapped(const uint8_t *data, size_t size, const WebPPicture *picture) {
+    auto *writer = static_cast<CappedWriter *>(picture->custom_ptr);
+    if (writer->limit > 0 && writer->buffer->size() + static_cast<qint64>(size) > writer->limit) {
+        writer->exceeded = true;
+        return 0;
+    }
+    writer->buffer->append(reinterpret_cast<const char *>(data), static_cast<qsizetype>(size));
+    return 1;
+}
+#endif
+}
+
+bool WebpCodec::isAvailable() {
+#if defined(IMGCOMPRESS_HAS_LIBWEBP)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool WebpCodec::decode(const QByteArray &data, QImage *image, QString *error) {
+#if defined(IMGCOMPRESS_HAS_LIBWEBP)
+    if (data.isEmpty() || !image) {
+        if (error) {
+            *error = "空文件";
+        }
+        return false;
+    }
+    const auto *bytes = reinterpret_cast<const uint8_t *>(data.constData());
+    const size_t size = static_cast<size_t>(data.size());
+    WebPDecoderConfig config;
+    if (!WebPInitDecoderConfig(&config) || WebPGetFeatures(bytes, size, &config.input) != VP8_STATUS_OK) {
+        if (error) {
+            *error = "WebP 文件头无效";
+        }
+        return false;
+    }
+    if (config.input.has_animation) {
+        if (error) {
+            *error = "不支持动画 WebP";
+        }
+        return false;
+    }
+    const bool alpha = config.input.has_alpha != 0;
+    QImage decoded(config.input.width, config.input.height, alpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+    if (decoded.isNull()) {
+        if (error) {
+            *error = "内存不足";
+        }
+        return false;
+    }
+    config.options.use_threads = 1;
+    config.output.colorspace = alpha ? MODE_RGBA : MODE_RGB;
+    config.output.is_external_memory = 1;
+    config.output.u.RGBA.rgba = decoded.bits();
+    config.output.u.RGBA.stride = static_cast<int>(decoded.bytesPerLine());
+    config.output.u.RGBA.size = static_cast<size_t>(decoded.sizeInBytes());
+    const VP8StatusCode status = WebPDecode(bytes, size, &config);
+    WebPFreeDecBuffer(&config.output);
+    if (status != VP8_STATUS_OK) {
+        if (error) {
+            *error = QString("WebP 解码失败(%1)").arg(static_cast<int>(status));
+        }
+        return false;
+    }
+    *image = decoded;
+    return true;
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(image);
+    if (error) {
+        *error = "未启用内置 WebP 编解码器";
+    }
+    return false;
+#endif
+}
+
+WebpCodec::Status WebpCodec::encode(
+    const QImage &image,
+    const WebpEncodeSettings &settings,
+    qint64 sizeLimit,
+    QByteArray *output,
+    QString *error
+) {
+#if defined(IMGCOMPRESS_HAS_LIBWEBP)
+    if (image.isNull() || !output) {
+        if (error) {
+            *error = "无效的像素数据";
+        }
+        return Status::Failed;
+    }
+    WebPConfig config;
+    if (!WebPConfigInit(&config)) {
+        if (error) {
+            *error = "libwebp 版本不匹配";
+        }
+        return Status::Failed;
+    }
+    if (settings.lossless) {
+        WebPConfigLosslessPreset(&config, 9);
+    } else {
+        config.quality = static_cast<float>(settings.quality);
+        config.method = settings.method;
+    }
+    config.thread_level = settings.threadLevel;
+    const bool alpha = image.hasAlphaChannel();
+    const QImage pixels = image.convertToFormat(alpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+    WebPPicture picture;
+    if (!WebPPictureInit(&picture)) {
+        if (error) {
+            *error = "libwebp 版本不匹配";
+        }
+        return Status::Failed;
+    }
+    picture.width = pixels.width();
+    picture.height = pixels.height();
+    picture.use_argb = settings.lossless ? 1 : 0;
+    const int stride = static_cast<int>(pixels.bytesPerLine());
+    const int imported = alpha
+        ? WebPPictureImportRGBA(&picture, pixels.constBits(), stride)
+        : WebPPictureImportRGB(&picture, pixels.constBits(), stride);
+    if (!imported) {
+        WebPPictureFree(&picture);
+        if (error) {
+            *error = "内存不足";
+        }
+        return Status::Failed;
+    }
+    QByteArray encoded;
+    CappedWriter writer{&encoded, sizeLimit, false};
+    picture.writer = writeCapped;
+    picture.custom_ptr = &writer;
+    const int finished = WebPEncode(&config, &picture);
+    const int errorCode = static_cast<int>(picture.error_code);
+    WebPPictureFree(&picture);
+    if (writer.exceeded) {
+        return Status::TooLarge;
+    }
+    if (!finished) {
+        if (error) {
+            *error = QString("WebP 编码失败(%1)").arg(errorCode);
+        }
+        return Status::Failed;
+    }
+    *output = encoded;
+    return Status::Success;
+#else
+    Q_UNUSED(image);
+    Q_UNUSED(settings);
+    Q_UNUSED(sizeLimit);
+    Q_UNUSED(output);
+    if (error) {
+        *error = "未启用内置 WebP 编解码器";
+    }
+    return Status::Failed;
+#endif
+}
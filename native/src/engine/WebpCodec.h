@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+class QImage;
+
+struct WebpEncodeSettings {
+    bool lossless;
+    int quality;
+    int method;
+    int threadLevel;
+};
+
+class WebpCodec {
+public:
+    enum class Status {
+        Success,
+        TooLarge,
+        Failed
+    };
+
+    static bool isAvailable();
+    static bool decode(const QByteArray &data, QImage *image, QString *error);
+    static Status encode(
+        const QImage &image,
+        const WebpEncodeSettings &settings,
+        qint64 sizeLimit,
+        QByteArray *output,
+        QString *error
+    );
+};